@@ -0,0 +1,91 @@
+#include "ClockSync.h"
+
+ClockSync::ClockSync() {
+  reset();
+}
+
+void ClockSync::reset() {
+  filterCount = 0;
+  filterIndex = 0;
+  pointCount = 0;
+  pointIndex = 0;
+  lastPointTime = INT64_MIN;
+  lastDelay = 0;
+  refTime = 0;
+  refOffset = 0;
+  drift = 0.0f;
+}
+
+void ClockSync::addExchange(int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+  Exchange exchange;
+  exchange.localTime = t1 + (t4 - t1) / 2;
+  exchange.offset = ((t2 - t1) + (t3 - t4)) / 2;
+  exchange.delay = (t4 - t1) - (t3 - t2);
+  lastDelay = exchange.delay;
+
+  if (exchange.delay < 0 || exchange.delay > MAX_DELAY) return;
+
+  int64_t error = exchange.offset - offsetAt(exchange.localTime);
+  if (isSynced() && (error > RESET_THRESHOLD || error < -RESET_THRESHOLD)) {
+    reset();
+  }
+
+  filter[filterIndex] = exchange;
+  filterIndex = (filterIndex + 1) % FILTER_SIZE;
+  if (filterCount < FILTER_SIZE) filterCount++;
+
+  // clock filter: trust the least delayed exchange of the recent ones
+  int best = 0;
+  for (int i = 1; i < filterCount; i++) {
+    if (filter[i].delay < filter[best].delay) best = i;
+  }
+  if (filter[best].localTime > lastPointTime) {
+    addPoint(filter[best]);
+  }
+}
+
+void ClockSync::addPoint(const Exchange& exchange) {
+  points[pointIndex] = exchange;
+  pointIndex = (pointIndex + 1) % POINT_COUNT;
+  if (pointCount < POINT_COUNT) pointCount++;
+  lastPointTime = exchange.localTime;
+  fit();
+}
+
+void ClockSync::fit() {
+  // least squares line through the points, relative to the newest point
+  const Exchange& newest = points[(pointIndex + POINT_COUNT - 1) % POINT_COUNT];
+  float sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+  int64_t oldestTime = newest.localTime;
+  for (int i = 0; i < pointCount; i++) {
+    float x = (float)(points[i].localTime - newest.localTime) * 1e-6f; // seconds
+    float y = (float)(points[i].offset - newest.offset);               // microseconds
+    sumX += x;
+    sumY += y;
+    sumXX += x * x;
+    sumXY += x * y;
+    if (points[i].localTime < oldestTime) oldestTime = points[i].localTime;
+  }
+  float n = (float) pointCount;
+  float meanX = sumX / n;
+  float meanY = sumY / n;
+
+  refTime = newest.localTime + (int64_t)(meanX * 1e6f);
+  refOffset = newest.offset + (int64_t) meanY;
+
+  float varX = sumXX - sumX * meanX;
+  if (newest.localTime - oldestTime >= MIN_DRIFT_SPAN && varX > 0.0f) {
+    drift = (sumXY - sumX * meanY) / varX * 1e-6f; // microseconds per microsecond
+  } else {
+    drift = 0.0f;
+  }
+}
+
+int64_t ClockSync::offsetAt(int64_t localTime) const {
+  return refOffset + (int64_t)((float)(localTime - refTime) * drift);
+}
+
+int64_t ClockSync::senderToLocal(int64_t senderTime) const {
+  // the offset changes so slowly that evaluating it at the uncorrected time is exact enough
+  return senderTime - offsetAt(senderTime - refOffset);
+}
@@ -0,0 +1,65 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <stdint.h>
+
+// NTP style estimate of a sender clock relative to the local clock.
+// All times are microseconds, the offset is sender time minus local time.
+//
+// Every exchange gives an offset and a round trip delay. The exchange with
+// the smallest delay out of the last few is the least disturbed by queueing,
+// those are kept and a line is fitted through them to follow clock drift.
+class ClockSync {
+public:
+  ClockSync();
+
+  void reset();
+
+  // t1, t4: local send and receive time of the request
+  // t2, t3: sender receive and reply time
+  void addExchange(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+  bool isSynced() const { return pointCount > 0; }
+
+  // Convert a sender timestamp to the local clock
+  int64_t senderToLocal(int64_t senderTime) const;
+
+  // Offset at the given local time
+  int64_t offsetAt(int64_t localTime) const;
+
+  float getDriftPpm() const { return drift * 1e6f; }
+  int64_t getRoundTrip() const { return lastDelay; }
+
+private:
+  static const int FILTER_SIZE = 8;
+  static const int POINT_COUNT = 16;
+  static const int64_t MAX_DELAY = 100000;     // ignore exchanges slower than 100ms
+  static const int64_t RESET_THRESHOLD = 50000; // sender rebooted or clock jumped
+  static const int64_t MIN_DRIFT_SPAN = 8000000; // fit drift over at least 8s
+
+  struct Exchange {
+    int64_t localTime;
+    int64_t offset;
+    int64_t delay;
+  };
+
+  Exchange filter[FILTER_SIZE];
+  int filterCount;
+  int filterIndex;
+
+  Exchange points[POINT_COUNT];
+  int pointCount;
+  int pointIndex;
+  int64_t lastPointTime;
+  int64_t lastDelay;
+
+  // offset(t) = refOffset + drift * (t - refTime)
+  int64_t refTime;
+  int64_t refOffset;
+  float drift;
+
+  void addPoint(const Exchange& exchange);
+  void fit();
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "JitterBuffer.h"
+#include <string.h>
+
+JitterBuffer::JitterBuffer()
+  : count(0), autoDepth(true), depth(10000), minDepth(2000), maxDepth(50000),
+    transitInitialized(false), transitMean(0), jitter(0), lateCount(0) {
+}
+
+void JitterBuffer::setDepth(int32_t depth) {
+  autoDepth = false;
+  this->depth = depth;
+}
+
+void JitterBuffer::setAutoDepth(int32_t minDepth, int32_t maxDepth) {
+  autoDepth = true;
+  this->minDepth = minDepth;
+  this->maxDepth = maxDepth;
+  if (depth < minDepth) depth = minDepth;
+  if (depth > maxDepth) depth = maxDepth;
+}
+
+void JitterBuffer::observeTransit(int32_t transit) {
+  if (!transitInitialized) {
+    transitMean = transit;
+    jitter = 0;
+    transitInitialized = true;
+  }
+  int32_t deviation = transit - transitMean;
+  transitMean += deviation / 16;
+  jitter += ((deviation < 0 ? -deviation : deviation) - jitter) / 16;
+
+  if (!autoDepth) return;
+
+  // cover nearly all packets, then move slowly so playout stays steady
+  int32_t target = transitMean + 4 * jitter;
+  if (target < minDepth) target = minDepth;
+  if (target > maxDepth) target = maxDepth;
+  depth += (target - depth) / 32;
+}
+
+bool JitterBuffer::schedule(int64_t sampleTime, int64_t now, uint8_t command_and_channel, uint8_t parameter1, uint8_t parameter2) {
+  if (count >= CAPACITY) return false;
+
+  int64_t dueTime = sampleTime + depth;
+  if (dueTime < now) {
+    lateCount++;
+    if (autoDepth) {
+      // late messages mean the buffer is too shallow, grow at once
+      int64_t grown = depth + (now - dueTime);
+      depth = (int32_t)(grown > maxDepth ? maxDepth : grown);
+    }
+    dueTime = now;
+  }
+
+  // insert after messages with the same due time to keep their order
+  size_t position = count;
+  while (position > 0 && messages[position - 1].dueTime > dueTime) {
+    position--;
+  }
+  memmove(&messages[position + 1], &messages[position], (count - position) * sizeof(ScheduledMidiMessage));
+  messages[position].dueTime = dueTime;
+  messages[position].command_and_channel = command_and_channel;
+  messages[position].parameter1 = parameter1;
+  messages[position].parameter2 = parameter2;
+  count++;
+  return true;
+}
+
+bool JitterBuffer::popDue(int64_t now, ScheduledMidiMessage& message) {
+  if (count == 0 || messages[0].dueTime > now) return false;
+
+  message = messages[0];
+  count--;
+  memmove(&messages[0], &messages[1], count * sizeof(ScheduledMidiMessage));
+  return true;
+}
@@ -0,0 +1,61 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct ScheduledMidiMessage {
+  int64_t dueTime;
+  uint8_t command_and_channel;
+  uint8_t parameter1;
+  uint8_t parameter2;
+};
+
+// Holds time tagged MIDI messages back for a constant delay after their
+// sample time so network jitter does not end up in the MIDI timing.
+// The delay (depth) is either fixed or tuned from the observed transit times.
+class JitterBuffer {
+public:
+  JitterBuffer();
+
+  // Fixed depth in microseconds, disables auto tuning
+  void setDepth(int32_t depth);
+
+  // Tune the depth from observed transit times within the given bounds
+  void setAutoDepth(int32_t minDepth, int32_t maxDepth);
+
+  int32_t getDepth() const { return depth; }
+  int32_t getJitter() const { return jitter; }
+  uint32_t getLateCount() const { return lateCount; }
+  size_t size() const { return count; }
+
+  // Transit is arrival time minus sample time, both on the local clock.
+  // Call once per received packet.
+  void observeTransit(int32_t transit);
+
+  // Schedule a message for sampleTime + depth. Messages that are already
+  // late are released on the next call to popDue. Returns false when full.
+  bool schedule(int64_t sampleTime, int64_t now, uint8_t command_and_channel, uint8_t parameter1, uint8_t parameter2);
+
+  // Pops the next message that is due, returns false if there is none
+  bool popDue(int64_t now, ScheduledMidiMessage& message);
+
+private:
+  static const size_t CAPACITY = 64;
+
+  ScheduledMidiMessage messages[CAPACITY]; // sorted by due time
+  size_t count;
+
+  bool autoDepth;
+  int32_t depth;
+  int32_t minDepth;
+  int32_t maxDepth;
+
+  // running transit statistics (RFC 3550 style, gain 1/16)
+  bool transitInitialized;
+  int32_t transitMean;
+  int32_t jitter;
+  uint32_t lateCount;
+};
+
+#endif
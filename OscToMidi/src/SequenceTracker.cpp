@@ -0,0 +1,59 @@
+#include "SequenceTracker.h"
+
+SequenceTracker::SequenceTracker() {
+  reset();
+}
+
+void SequenceTracker::reset() {
+  started = false;
+  highest = 0;
+  window = 0;
+  received = 0;
+  lost = 0;
+  reordered = 0;
+  duplicates = 0;
+}
+
+SequenceTracker::Result SequenceTracker::update(uint32_t sequence) {
+  int32_t diff = (int32_t)(sequence - highest);
+
+  if (!started || diff > MAX_JUMP || diff < -MAX_JUMP) {
+    started = true;
+    highest = sequence;
+    window = 1;
+    received++;
+    return SEQUENCE_NEW;
+  }
+
+  if (diff > 0) {
+    window = (diff >= 64) ? 1 : (window << diff) | 1;
+    lost += diff - 1;
+    highest = sequence;
+    received++;
+    return SEQUENCE_NEW;
+  }
+
+  if (diff == 0) {
+    duplicates++;
+    return SEQUENCE_DUPLICATE;
+  }
+
+  uint32_t age = (uint32_t) -diff;
+  if (age < 64) {
+    uint64_t bit = (uint64_t) 1 << age;
+    if (window & bit) {
+      duplicates++;
+      return SEQUENCE_DUPLICATE;
+    }
+    window |= bit;
+    if (lost > 0) lost--; // was counted as lost when the gap appeared
+  }
+  reordered++;
+  received++;
+  return SEQUENCE_LATE;
+}
+
+float SequenceTracker::getLossRatio() const {
+  uint32_t total = received + lost;
+  return total > 0 ? (float) lost / (float) total : 0.0f;
+}
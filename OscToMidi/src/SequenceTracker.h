@@ -0,0 +1,45 @@
+#ifndef SEQUENCE_TRACKER_H
+#define SEQUENCE_TRACKER_H
+
+#include <stdint.h>
+
+// Follows the /seq numbers of one sender.
+// Keeps a window of the last 64 sequence numbers to tell late (reordered)
+// packets from duplicates, and counts the packets that never arrived.
+class SequenceTracker {
+public:
+  enum Result {
+    SEQUENCE_NEW,       // newest packet so far
+    SEQUENCE_LATE,      // older than a packet that was already received
+    SEQUENCE_DUPLICATE  // received before
+  };
+
+  SequenceTracker();
+
+  void reset();
+
+  Result update(uint32_t sequence);
+
+  uint32_t getReceived() const { return received; }
+  uint32_t getLost() const { return lost; }
+  uint32_t getReordered() const { return reordered; }
+  uint32_t getDuplicates() const { return duplicates; }
+
+  // Lost packets as a fraction of all packets sent
+  float getLossRatio() const;
+
+private:
+  // A jump larger than this means the sender restarted its count
+  static const int32_t MAX_JUMP = 1000;
+
+  bool started;
+  uint32_t highest;
+  uint64_t window; // bit n set: highest - n was received
+
+  uint32_t received;
+  uint32_t lost;
+  uint32_t reordered;
+  uint32_t duplicates;
+};
+
+#endif
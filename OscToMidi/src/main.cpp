@@ -3,7 +3,12 @@
 #include <WiFi.h>
 #include <WiFiUdp.h>
 #include <MicroOscUdp.h>
+#include <MicroOscUtility.h>
 #include <FastLED.h> 
+#include <esp_timer.h>
+#include "ClockSync.h"
+#include "JitterBuffer.h"
+#include "SequenceTracker.h"
 
 // For debugging purposes; 
 // Use this switch to enable USB MIDI functionality
@@ -18,10 +23,42 @@ struct MidiMessage {
   uint8_t parameter1;
   uint8_t parameter2;
 };
-const size_t midi_duplicate_filter_size = 5; // Number of previous messages to remember
+const size_t midi_duplicate_filter_size = 16; // Number of controllers to remember
 static MidiMessage midi_duplicate_filter_history[midi_duplicate_filter_size];
 static int midi_duplicate_filter_history_index = 0;
 
+// Senders time tag their bundles with the sample time. Once the sender clock is
+// synchronized, messages are held in a jitter buffer and played out at a constant
+// delay after sampling: a few ms of extra latency for steady MIDI timing.
+const boolean enableJitterBuffer = true;
+const int32_t jitter_buffer_depth_us = 0; // fixed playout delay, 0 tunes it from the observed jitter
+const int32_t jitter_buffer_min_depth_us = 2000;
+const int32_t jitter_buffer_max_depth_us = 40000;
+JitterBuffer jitterBuffer;
+
+// Clock sync with every sender (NTP style /sync round trips)
+const unsigned long sync_interval_ms = 1000;
+const unsigned long sync_fast_interval_ms = 100; // right after a sender shows up
+const int sync_fast_count = 8;
+const unsigned long sender_timeout_ms = 10000;
+struct OscSender {
+  IPAddress ip;
+  uint16_t port;
+  ClockSync clock;
+  unsigned long lastSeen;
+  unsigned long lastSyncSent;
+  int syncCount;
+  uint64_t lastTimeTag;
+  SequenceTracker sequence;
+  SequenceTracker::Result packetSequence; // of the packet being parsed
+  uint32_t dropped;
+  bool active;
+};
+const size_t max_senders = 4;
+static OscSender senders[max_senders];
+const unsigned long link_stats_interval_ms = 5000;
+static unsigned long linkStatsPrinted = 0;
+
 // WiFi Access Point credentials
 const int device_id = 6;
 const char* ap_ssid_format = "OSC-to-MIDI-%02d"; 
@@ -81,7 +118,13 @@ void setupHeartbeatLed();
 bool isDuplicateMIDIMessage(uint8_t command_and_channel, uint8_t parameter1, uint8_t parameter2);
 void sendMidiCC(uint8_t controller, uint8_t value);
 void myOnOscMessageReceived(MicroOscMessage& receivedOscMessage);
-void handleMidiMessage(MicroOscMessage& message);
+void handleMidiMessage(MicroOscMessage& message, OscSender* sender, int64_t arrivalTime);
+void handleSyncReply(MicroOscMessage& message, OscSender* sender, int64_t arrivalTime);
+void handleSequenceNumber(MicroOscMessage& message, OscSender* sender);
+void printLinkStats();
+OscSender* findOrAddSender(IPAddress ip, uint16_t port);
+void syncSenders();
+void releaseScheduledMidiMessages();
 
 // Setup USB MIDI
 #ifdef USE_USB_MIDI
@@ -169,24 +212,26 @@ void sendMidiMessage(uint8_t command_and_channel, uint8_t parameter1, uint8_t pa
 
 
 bool isDuplicateMIDIMessage(uint8_t command_and_channel, uint8_t parameter1, uint8_t parameter2) {
-  // Search through history to find an entry with matching command_and_channel
+  // Only controller values are filtered: a repeated note on is a new hit
+  if ((command_and_channel & 0xF0) != 0xB0) {
+    return false;
+  }
+
+  // Search through history to find an entry for the same controller on the same channel
   for (size_t i = 0; i < midi_duplicate_filter_size; i++) {
-    // Found an entry with the same command and channel
-    if (midi_duplicate_filter_history[i].command_and_channel == command_and_channel) {
-      // Check if all parameters match (this would be a duplicate)
-      if (midi_duplicate_filter_history[i].parameter1 == parameter1 && 
-          midi_duplicate_filter_history[i].parameter2 == parameter2) {
-        return true; // It's a duplicate - same command/channel with same parameters
+    if (midi_duplicate_filter_history[i].command_and_channel == command_and_channel &&
+        midi_duplicate_filter_history[i].parameter1 == parameter1) {
+      if (midi_duplicate_filter_history[i].parameter2 == parameter2) {
+        return true; // It's a duplicate - same controller with the same value
       } else {
-        // Same command/channel but different parameters - update and not a duplicate
-        midi_duplicate_filter_history[i].parameter1 = parameter1;
+        // Same controller but a new value - update and not a duplicate
         midi_duplicate_filter_history[i].parameter2 = parameter2;
         return false;
       }
     }
   }
   
-  // command_and_channel not found in history - need to add it
+  // controller not found in history - need to add it
   // Find an empty slot or use the oldest slot (LRU replacement)
   int slot_to_use = -1;
   
@@ -209,7 +254,7 @@ bool isDuplicateMIDIMessage(uint8_t command_and_channel, uint8_t parameter1, uin
   midi_duplicate_filter_history[slot_to_use].parameter1 = parameter1;
   midi_duplicate_filter_history[slot_to_use].parameter2 = parameter2;
   
-  return false; // Not a duplicate (new command_and_channel)
+  return false; // Not a duplicate (new controller)
 }
 
 
@@ -286,7 +331,7 @@ void setupMDNS() {
 
 static unsigned long prevMillis = 0;
 // Handle MIDI messages from OSC
-void handleMidiMessage(MicroOscMessage& message) {  
+void handleMidiMessage(MicroOscMessage& message, OscSender* sender, int64_t arrivalTime) {  
   // Read the first integer as controller number, second as value
   int32_t command_and_channel = message.nextAsInt();
   int32_t parameter1 = message.nextAsInt();
@@ -303,16 +348,130 @@ void handleMidiMessage(MicroOscMessage& message) {
   unsigned long diff = currMillis - prevMillis;
   if (enableSerial) Serial.printf("[%lu ms] OSC to MIDI: Command and channel %d, Parameter 1 %d, Parameter 2 %d (Δ%lu ms)\n", currMillis, command_and_channel, parameter1, parameter2, diff);
   prevMillis = currMillis;
+
+  // A late packet must not overwrite newer controller or pitch bend values;
+  // late notes and real-time messages are still played, a duplicate not at all
+  uint8_t command = command_and_channel & 0xF0;
+  bool isValue = command == 0xB0 || command == 0xE0;
+  SequenceTracker::Result sequence = sender != NULL ? sender->packetSequence : SequenceTracker::SEQUENCE_NEW;
+  if ((sequence == SequenceTracker::SEQUENCE_LATE && isValue) || sequence == SequenceTracker::SEQUENCE_DUPLICATE) {
+    sender->dropped++;
+    return;
+  }
+
+  // Time tagged and synchronized: play out from the jitter buffer
+  uint64_t timeTag = myMicroOsc.getBundleTimeTag();
+  if (enableJitterBuffer && sender != NULL && sender->clock.isSynced() && timeTag > 1) {
+    int64_t sampleTime = sender->clock.senderToLocal((int64_t) uOsc_timeTagToMicros(timeTag));
+    if (timeTag != sender->lastTimeTag) {
+      // one transit observation per bundle
+      jitterBuffer.observeTransit((int32_t)(arrivalTime - sampleTime));
+      sender->lastTimeTag = timeTag;
+    }
+    if (jitterBuffer.schedule(sampleTime, arrivalTime, (uint8_t)command_and_channel, (uint8_t)parameter1, (uint8_t)parameter2)) {
+      return;
+    }
+  }
   
   // Send MIDI CC message
   sendMidiMessage((uint8_t)command_and_channel, (uint8_t)parameter1, (uint8_t)parameter2, virtual_cable_num);
 }
 
+// Completes a clock sync round trip: /sync/reply <t1> <t2> <t3>
+void handleSyncReply(MicroOscMessage& message, OscSender* sender, int64_t arrivalTime) {
+  if (sender == NULL) return;
+  int64_t t1 = message.nextAsInt64();
+  int64_t t2 = message.nextAsInt64();
+  int64_t t3 = message.nextAsInt64();
+  sender->clock.addExchange(t1, t2, t3, arrivalTime);
+  if (enableSerial) Serial.printf("Clock sync %s: offset %lld us, round trip %lld us, drift %.2f ppm, buffer depth %ld us, jitter %ld us\n",
+    sender->ip.toString().c_str(), sender->clock.offsetAt(arrivalTime), sender->clock.getRoundTrip(), sender->clock.getDriftPpm(),
+    (long) jitterBuffer.getDepth(), (long) jitterBuffer.getJitter());
+}
+
+// /seq <n> is the first element of every sender bundle
+void handleSequenceNumber(MicroOscMessage& message, OscSender* sender) {
+  if (sender == NULL) return;
+  sender->packetSequence = sender->sequence.update((uint32_t) message.nextAsInt());
+}
+
+void printLinkStats() {
+  for (size_t i = 0; i < max_senders; i++) {
+    const OscSender& sender = senders[i];
+    if (!sender.active) continue;
+    Serial.printf("Link %s: received %lu, lost %lu (%.2f%%), reordered %lu, duplicates %lu, dropped %lu, late playout %lu\n",
+      sender.ip.toString().c_str(), (unsigned long) sender.sequence.getReceived(), (unsigned long) sender.sequence.getLost(),
+      sender.sequence.getLossRatio() * 100.0f, (unsigned long) sender.sequence.getReordered(),
+      (unsigned long) sender.sequence.getDuplicates(), (unsigned long) sender.dropped, (unsigned long) jitterBuffer.getLateCount());
+  }
+}
+
+OscSender* findOrAddSender(IPAddress ip, uint16_t port) {
+  unsigned long now = millis();
+  OscSender* free_slot = NULL;
+  for (size_t i = 0; i < max_senders; i++) {
+    if (senders[i].active && now - senders[i].lastSeen > sender_timeout_ms) {
+      senders[i].active = false;
+    }
+    if (senders[i].active && senders[i].ip == ip && senders[i].port == port) {
+      senders[i].lastSeen = now;
+      return &senders[i];
+    }
+    if (!senders[i].active && free_slot == NULL) free_slot = &senders[i];
+  }
+  if (free_slot == NULL) return NULL;
+
+  free_slot->ip = ip;
+  free_slot->port = port;
+  free_slot->clock.reset();
+  free_slot->lastSeen = now;
+  free_slot->lastSyncSent = 0;
+  free_slot->syncCount = 0;
+  free_slot->lastTimeTag = 0;
+  free_slot->sequence.reset();
+  free_slot->packetSequence = SequenceTracker::SEQUENCE_NEW;
+  free_slot->dropped = 0;
+  free_slot->active = true;
+  if (enableSerial) Serial.printf("New sender %s:%d\n", ip.toString().c_str(), port);
+  return free_slot;
+}
+
+// Send clock sync requests, fast at first and then once per interval
+void syncSenders() {
+  unsigned long now = millis();
+  for (size_t i = 0; i < max_senders; i++) {
+    OscSender& sender = senders[i];
+    if (!sender.active) continue;
+    unsigned long interval = sender.syncCount < sync_fast_count ? sync_fast_interval_ms : sync_interval_ms;
+    if (now - sender.lastSyncSent < interval) continue;
+
+    sender.lastSyncSent = now;
+    sender.syncCount++;
+    myMicroOsc.setDestination(sender.ip, sender.port);
+    myMicroOsc.sendInt64("/sync", (uint64_t) esp_timer_get_time());
+  }
+}
+
+void releaseScheduledMidiMessages() {
+  ScheduledMidiMessage message;
+  int64_t now = esp_timer_get_time();
+  while (jitterBuffer.popDue(now, message)) {
+    sendMidiMessage(message.command_and_channel, message.parameter1, message.parameter2, 0);
+  }
+}
+
 // Function that will be called when an OSC message is received
 void myOnOscMessageReceived(MicroOscMessage& receivedOscMessage) {  
+  int64_t arrivalTime = esp_timer_get_time();
+  OscSender* sender = findOrAddSender(myUdp.remoteIP(), myUdp.remotePort());
+
   // Handle MIDI messages at address "/midi"
   if (receivedOscMessage.checkOscAddress("/midi")) {
-    handleMidiMessage(receivedOscMessage);
+    handleMidiMessage(receivedOscMessage, sender, arrivalTime);
+  } else if (receivedOscMessage.checkOscAddressAndTypeTags("/seq", "i")) {
+    handleSequenceNumber(receivedOscMessage, sender);
+  } else if (receivedOscMessage.checkOscAddressAndTypeTags("/sync/reply", "hhh")) {
+    handleSyncReply(receivedOscMessage, sender, arrivalTime);
   } else {
     if (enableSerial) Serial.println("Received OSC message with unhandled address");
   }
@@ -339,6 +498,12 @@ void setup() {
   setupMDNS();
   setupHeartbeatLed();
 
+  if (jitter_buffer_depth_us > 0) {
+    jitterBuffer.setDepth(jitter_buffer_depth_us);
+  } else {
+    jitterBuffer.setAutoDepth(jitter_buffer_min_depth_us, jitter_buffer_max_depth_us);
+  }
+
   for (size_t i = i=0; i < 10; i++) {
     toggleHeartbeatLed(CRGB::Red); // Blink green to indicate ready state
     delay(500);
@@ -350,12 +515,24 @@ void setup() {
 void loop() {
   // Check for incoming OSC messages and call the callback function for each received message
   myMicroOsc.onOscMessageReceived(myOnOscMessageReceived);
+  for (size_t i = 0; i < max_senders; i++) {
+    senders[i].packetSequence = SequenceTracker::SEQUENCE_NEW; // only applies to the packet that was just parsed
+  }
+
+  // Play out buffered messages that are due and keep the sender clocks synchronized
+  releaseScheduledMidiMessages();
+  syncSenders();
+
+  if (enableSerial && millis() - linkStatsPrinted > link_stats_interval_ms) {
+    linkStatsPrinted = millis();
+    printLinkStats();
+  }
 
   #ifdef USE_USB_MIDI
     // Keep USB MIDI responsive
     //tud_task(); // Process USB stack for MIDI
   #endif
   
-  // Small delay to prevent overwhelming the CPU
-  delay(2);
+  // Small delay to prevent overwhelming the CPU, also the playout resolution
+  delay(1);
 }
@@ -0,0 +1,29 @@
+// Host version of the on-device AHRS benchmark (AHRS_BENCHMARK build flag),
+// runs the same backends on the same synthetic trace. See README.md.
+
+#include <chrono>
+#include <cstdio>
+#include "imu/AhrsBenchmark.h"
+#include "imu/mahony/MahonyAHRS.h"
+#include "imu/madgwick/MadgwickAHRS.h"
+#include "imu/complementary/ComplementaryFilter.h"
+
+int main() {
+    static imu::AhrsBenchmark benchmark;
+    imu::mahony::MahonyAHRS mahony;
+    imu::madgwick::MadgwickAHRS madgwick;
+    imu::complementary::ComplementaryFilter complementary;
+    imu::Ahrs* backends[] = { &mahony, &madgwick, &complementary };
+
+    for (imu::Ahrs* ahrs : backends) {
+        auto start = std::chrono::steady_clock::now();
+        imu::AhrsBenchmark::Result result = benchmark.run(*ahrs, 64);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        // run() goes over the trace twice per pass
+        double ns = elapsed / (2.0 * result.updates);
+        printf("%-13s %7.1f cycles %6.1f ns per update, max %u cycles, q %.4f %.4f %.4f %.4f\n",
+            result.name, result.meanCycles, ns, result.maxCycles,
+            result.quat[0], result.quat[1], result.quat[2], result.quat[3]);
+    }
+    return 0;
+}
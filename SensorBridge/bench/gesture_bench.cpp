@@ -0,0 +1,93 @@
+// Runs a recorded IMU trace (see imu/TraceRecorder.h) through the gesture
+// recognizer. Templates are recorded from the trace itself, at the given
+// times, as /gesture/record does on the device; every later match is
+// printed. Also measures the recognizer's cost per sample. See README.md.
+//
+// usage: gesture_bench <trace> --record <slot>@<seconds> [--record ...]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "imu/GestureRecognizer.h"
+#include "imu/CycleCounter.h"
+#include "imu/TraceRecorder.h"
+
+struct Recording {
+    int slot;
+    int64_t time;   // us after the first sample
+    bool started;
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <trace> --record <slot>@<seconds> [--record ...]\n", argv[0]);
+        return 1;
+    }
+    static const int MaxRecordings = 16;
+    Recording recordings[MaxRecordings];
+    int recordingCount = 0;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        int slot;
+        double seconds;
+        if (strcmp(argv[i], "--record") == 0 && recordingCount < MaxRecordings
+            && sscanf(argv[i + 1], "%d@%lf", &slot, &seconds) == 2) {
+            recordings[recordingCount++] = { slot, (int64_t) (seconds * 1e6), false };
+        }
+    }
+
+    FILE* file = fopen(argv[1], "r");
+    if (file == nullptr) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    static imu::GestureRecognizer recognizer;
+    char line[256];
+    unsigned long samples = 0;
+    unsigned long matches = 0;
+    int64_t firstTime = 0;
+    double totalNs = 0;
+    uint64_t totalCycles = 0;
+    uint32_t maxCycles = 0;
+    while (fgets(line, sizeof(line), file)) {
+        imu::ImuSample sample;
+        if (!imu::TraceRecorder::parseSample(line, sample)) continue;
+        if (samples == 0) firstTime = sample.timestamp;
+        samples++;
+
+        for (int i = 0; i < recordingCount; i++) {
+            if (!recordings[i].started && sample.timestamp - firstTime >= recordings[i].time) {
+                recordings[i].started = true;
+                recognizer.record(recordings[i].slot);
+            }
+        }
+
+        imu::GestureEvent event;
+        auto start = std::chrono::steady_clock::now();
+        uint32_t startCycles = imu::cycleCount();
+        bool found = recognizer.push(sample, event);
+        uint32_t cycles = imu::cycleCount() - startCycles;
+        totalNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        totalCycles += cycles;
+        if (cycles > maxCycles) maxCycles = cycles;
+
+        if (!found) continue;
+        double seconds = (event.timestamp - firstTime) * 1e-6;
+        if (event.recorded) {
+            const imu::GestureTemplate& gesture = recognizer.getTemplate(event.gesture);
+            printf("%.3f recorded %d: %d frames, threshold %d\n", seconds, event.gesture, gesture.length, gesture.threshold);
+        } else {
+            printf("%.3f gesture %d, distance %d\n", seconds, event.gesture, event.distance);
+            matches++;
+        }
+    }
+    fclose(file);
+
+    uint32_t comparisons = recognizer.getComparisonCount();
+    fprintf(stderr, "%lu samples, %lu matches, %u comparisons (%u abandoned early)\n",
+        samples, matches, comparisons, recognizer.getAbandonCount());
+    fprintf(stderr, "recognizer %.1f ns per sample, %llu cycles per sample (max %u)\n",
+        samples ? totalNs / samples : 0.0, samples ? (unsigned long long) (totalCycles / samples) : 0ULL, maxCycles);
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Replays an IMU trace recorded on the device (see imu/TraceRecorder.h)
+// through the same pipeline and MIDI mapping the firmware runs, and prints
+// the resulting MIDI stream. The output only depends on the trace and the
+// code, so it can be diffed before and after a change. See README.md.
+//
+// usage: imu_replay <trace> [--ahrs 0|1|2] [--mode <stream mode>] [--rate <Hz>]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "imu/ImuPipeline.h"
+#include "imu/TraceRecorder.h"
+#include "MidiMapper.h"
+
+// the firmware's main loop runs every 20 ms
+static const int64_t MainLoopPeriod = 20000;
+
+static int64_t outputTime = 0;
+static unsigned long messageCount = 0;
+
+static void printMidi(uint8_t status, uint8_t data1, uint8_t data2) {
+    printf("%lld %02X %d %d\n", (long long) outputTime, status, data1, data2);
+    messageCount++;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <trace> [--ahrs 0|1|2] [--mode <stream mode>] [--rate <Hz>]\n", argv[0]);
+        return 1;
+    }
+    int ahrsType = imu::AHRS_MAHONY;
+    int mode = STREAM_PITCH_JAW_ROLL_TAP;
+    float rate = 200.0f;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--ahrs") == 0) ahrsType = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--mode") == 0) mode = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--rate") == 0) rate = (float) atof(argv[i + 1]);
+    }
+
+    FILE* file = fopen(argv[1], "r");
+    if (file == nullptr) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    static imu::ImuPipeline pipeline;
+    static MidiMapper mapper;
+    pipeline.setSampleRate(rate);
+    if (!pipeline.setAhrs((imu::AhrsType) ahrsType)) {
+        fprintf(stderr, "unknown AHRS %d\n", ahrsType);
+        return 1;
+    }
+    // as on the device after connecting
+    pipeline.enableGyroBiasTracking(true);
+
+    char line[256];
+    unsigned long samples = 0;
+    int64_t nextLoop = 0;
+    double pipelineNs = 0;
+    while (fgets(line, sizeof(line), file)) {
+        imu::ImuSample sample;
+        if (!imu::TraceRecorder::parseSample(line, sample)) continue;
+
+        auto start = std::chrono::steady_clock::now();
+        pipeline.process(sample);
+        pipelineNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        samples++;
+
+        // taps and their note offs as the main loop's idle polling sends them
+        imu::TapEvent tap;
+        while (pipeline.popTapEvent(tap)) {
+            outputTime = tap.timestamp;
+            mapper.processTap(tap, (StreamOptions) mode, printMidi);
+        }
+        int64_t releaseTime;
+        while ((releaseTime = mapper.getNoteReleaseTime()) != 0 && sample.timestamp >= releaseTime) {
+            outputTime = releaseTime;
+            mapper.releaseNote(printMidi);
+        }
+
+        if (nextLoop == 0) nextLoop = sample.timestamp;
+        if (sample.timestamp >= nextLoop) {
+            outputTime = sample.timestamp;
+            mapper.process(pipeline.getData(), (StreamOptions) mode, printMidi);
+            nextLoop += MainLoopPeriod;
+            if (nextLoop <= sample.timestamp) nextLoop = sample.timestamp + MainLoopPeriod;
+        }
+    }
+    fclose(file);
+
+    imu::Ahrs::CycleStats cycles = pipeline.getAhrs().getCycleStats();
+    const imu::GyroBiasTracker& bias = pipeline.getGyroBiasTracker();
+    fprintf(stderr, "%lu samples, %lu MIDI messages, %s\n", samples, messageCount, pipeline.getAhrs().name());
+    fprintf(stderr, "pipeline %.1f ns per sample, AHRS %u cycles per update (max %u)\n",
+        samples ? pipelineNs / samples : 0.0, cycles.mean, cycles.max);
+    fprintf(stderr, "gyro bias %.4f %.4f %.4f deg/s after %u still windows\n",
+        bias.getBias()[0], bias.getBias()[1], bias.getBias()[2], bias.getUpdateCount());
+    return 0;
+}
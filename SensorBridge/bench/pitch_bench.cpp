@@ -0,0 +1,140 @@
+// Runs a WAV file through the microphone onset detector and pitch tracker
+// (audio/OnsetDetector.h, audio/PitchTracker.h) hop by hop, as the audio
+// task does on the device, and prints the pitch tracker's MIDI stream as
+// <time us> <status hex> <data1> <data2> lines and the onsets as comments.
+// Also measures the cost per hop and how long after its start an onset is
+// found. See README.md.
+//
+// usage: pitch_bench <wav> [--pitch]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "audio/PitchTracker.h"
+#include "imu/CycleCounter.h"
+
+static uint32_t readLe(const uint8_t* bytes, int count) {
+    uint32_t value = 0;
+    for (int i = count - 1; i >= 0; i--) value = (value << 8) | bytes[i];
+    return value;
+}
+
+// 16 bit PCM, channels mixed down to mono
+static bool readWav(const char* path, std::vector<int16_t>& samples, float& sampleRate) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        perror(path);
+        return false;
+    }
+    uint8_t header[12];
+    if (fread(header, 1, 12, file) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "%s: not a WAV file\n", path);
+        fclose(file);
+        return false;
+    }
+    int channels = 0;
+    int bits = 0;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, 8, file) == 8) {
+        uint32_t size = readLe(chunk + 4, 4);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t format[16];
+            if (size < 16 || fread(format, 1, 16, file) != 16) break;
+            fseek(file, size - 16 + (size & 1), SEEK_CUR);
+            channels = (int) readLe(format + 2, 2);
+            sampleRate = (float) readLe(format + 4, 4);
+            bits = (int) readLe(format + 14, 2);
+            if (readLe(format, 2) != 1 || bits != 16 || channels < 1) {
+                fprintf(stderr, "%s: only 16 bit PCM is supported\n", path);
+                fclose(file);
+                return false;
+            }
+        } else if (memcmp(chunk, "data", 4) == 0 && channels > 0) {
+            std::vector<int16_t> frames(size / 2);
+            size_t count = fread(frames.data(), 2, frames.size(), file);
+            for (size_t i = 0; i + channels <= count; i += channels) {
+                int sum = 0;
+                for (int c = 0; c < channels; c++) sum += frames[i + c];
+                samples.push_back((int16_t) (sum / channels));
+            }
+            fclose(file);
+            return true;
+        } else {
+            fseek(file, size + (size & 1), SEEK_CUR);
+        }
+    }
+    fprintf(stderr, "%s: no audio data\n", path);
+    fclose(file);
+    return false;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <wav> [--pitch]\n", argv[0]);
+        return 1;
+    }
+    const int hopSize = audio::PitchTracker::HopSize;
+    bool printPitch = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--pitch") == 0) printPitch = true;
+    }
+
+    std::vector<int16_t> samples;
+    float sampleRate = 0.0f;
+    if (!readWav(argv[1], samples, sampleRate)) return 1;
+    static audio::OnsetDetector detector;
+    static audio::PitchTracker tracker;
+    detector.begin(sampleRate);
+    tracker.begin(sampleRate);
+
+    audio::PitchEvent events[audio::PitchTracker::MaxEvents];
+    unsigned long hops = 0;
+    unsigned long messages = 0;
+    unsigned long onsets = 0;
+    double delaySum = 0;
+    double delayMax = 0;
+    double totalNs = 0;
+    uint64_t totalCycles = 0;
+    uint32_t maxCycles = 0;
+    for (size_t start = 0; start + hopSize <= samples.size(); start += hopSize) {
+        // the capture time of the hop's last sample
+        int64_t timestamp = (int64_t) ((start + hopSize) * 1e6 / sampleRate);
+        auto begin = std::chrono::steady_clock::now();
+        uint32_t startCycles = imu::cycleCount();
+        audio::OnsetEvent onset;
+        bool hasOnset = detector.process(&samples[start], hopSize, timestamp, onset);
+        int count = tracker.process(&samples[start], timestamp, hasOnset ? &onset : nullptr, events);
+        uint32_t cycles = imu::cycleCount() - startCycles;
+        totalNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        totalCycles += cycles;
+        if (cycles > maxCycles) maxCycles = cycles;
+        hops++;
+
+        if (hasOnset) {
+            // found at the end of the hop
+            double delay = (timestamp - onset.timestamp) * 1e-3;
+            delaySum += delay;
+            if (delay > delayMax) delayMax = delay;
+            onsets++;
+            printf("# %lld onset, level %.1f dBFS, velocity %d\n", (long long) onset.timestamp, onset.level, onset.velocity);
+        }
+        if (printPitch) {
+            printf("# %lld pitch %.2f Hz, probability %.3f, level %.4f\n", (long long) timestamp,
+                tracker.getPitch(), tracker.getProbability(), tracker.getLevel());
+        }
+        for (int i = 0; i < count; i++) {
+            printf("%lld %02X %d %d\n", (long long) events[i].timestamp, events[i].status, events[i].data1, events[i].data2);
+            messages++;
+        }
+    }
+
+    double hopNs = hops ? totalNs / hops : 0.0;
+    fprintf(stderr, "%lu hops of %d samples at %.0f Hz, %lu MIDI messages\n", hops, hopSize, sampleRate, messages);
+    fprintf(stderr, "%lu onsets, found %.1f ms after their start on average, %.1f ms at most\n",
+        onsets, onsets ? delaySum / onsets : 0.0, delayMax);
+    fprintf(stderr, "onsets and tracker %.1f us per hop (%.2f%% of real time), %llu cycles per hop (max %u)\n",
+        hopNs / 1000, hopNs / (hopSize * 1e9 / sampleRate) * 100, hops ? (unsigned long long) (totalCycles / hops) : 0ULL, maxCycles);
+    return 0;
+}
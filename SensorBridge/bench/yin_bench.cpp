@@ -0,0 +1,358 @@
+// Accuracy and cost of the YIN pitch estimators (yin/yin_fixed.h, buffer
+// based through the FFT, and yin/yin_stream.h, hop by hop) on synthetic
+// tones. Sweeps frequency, buffer size, sample rate, noise and harmonic
+// content and reports, per condition and estimator:
+//   voiced   share of estimates with a pitch
+//   median / p95 error in cents of the estimates within 50 cents
+//   octave   share of estimates an octave or two off (or a twelfth)
+//   gross    share of other estimates more than 50 cents off
+//   ns       time per estimate
+// followed by the calibration of the reported probability: for ranges of
+// probability, how many of those estimates were right. First runs the fixed
+// point arithmetic checks of yin/fixed_point.c and compares yin_fixed's FFT
+// difference function with the direct sum it replaced on the test tones of
+// yin/fixedpoint_math.c. See README.md.
+//
+// usage: yin_bench [--trials <n>] [--seed <n>]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "yin/yin_common.h"
+#include "yin/yin_fixed.h"
+#include "yin/yin_stream.h"
+
+extern "C" void test_fixed_point_math(void);  // yin/fixed_point.c, asserts
+
+enum Harmonics {
+    HARMONICS_SINE,
+    HARMONICS_SAW,      // all harmonics at 1/k
+    HARMONICS_ODD,      // odd harmonics at 1/k, square like
+    HARMONICS_WEAK,     // fundamental well below the 2nd and 3rd harmonic
+    HARMONICS_COUNT
+};
+
+static const char* HarmonicsNames[HARMONICS_COUNT] = { "sine", "saw", "odd", "weak f0" };
+
+struct Condition {
+    float sampleRate;
+    int bufferSize;     // yin_fixed only
+    float minFrequency;
+    float maxFrequency;
+    int harmonics;
+    float snr;          // dB, INFINITY without noise
+};
+
+// what is counted for the probability calibration
+static const int CalibrationBins = 6;
+static const float CalibrationEdges[CalibrationBins + 1] = { 0.0f, 0.5f, 0.7f, 0.8f, 0.9f, 0.95f, 1.01f };
+
+struct Result {
+    std::vector<float> errors;  // |cents| of the right estimates
+    int estimates = 0;
+    int voiced = 0;
+    int octave = 0;
+    int gross = 0;
+    double ns = 0;
+    int calibrationCount[CalibrationBins] = { };
+    int calibrationRight[CalibrationBins] = { };
+
+    void add(float pitch, float probability, float frequency) {
+        estimates++;
+        if (!(pitch > 0)) return;
+        voiced++;
+        float cents = 1200.0f * log2f(pitch / frequency);
+        bool right = fabsf(cents) <= 50.0f;
+        if (right) {
+            errors.push_back(fabsf(cents));
+        } else if (fabsf(fabsf(cents) - 1200.0f) <= 50.0f || fabsf(fabsf(cents) - 2400.0f) <= 50.0f
+                   || fabsf(fabsf(cents) - 1902.0f) <= 50.0f) {
+            octave++;
+        } else {
+            gross++;
+        }
+        for (int i = 0; i < CalibrationBins; i++) {
+            if (probability >= CalibrationEdges[i] && probability < CalibrationEdges[i + 1]) {
+                calibrationCount[i]++;
+                if (right) calibrationRight[i]++;
+            }
+        }
+    }
+
+    void merge(const Result& other) {
+        for (int i = 0; i < CalibrationBins; i++) {
+            calibrationCount[i] += other.calibrationCount[i];
+            calibrationRight[i] += other.calibrationRight[i];
+        }
+    }
+};
+
+static std::mt19937 generator;
+
+// amplitude 0.5 at the peak, random phases
+static void generate(const Condition& condition, float frequency, std::vector<int16_t>& out, size_t count) {
+    std::uniform_real_distribution<float> phaseDistribution(0.0f, 2.0f * (float) M_PI);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    float amplitudes[16] = { };
+    float phases[16];
+    int harmonicCount = 0;
+    for (int k = 1; k <= 16 && k * frequency < condition.sampleRate / 2; k++) {
+        switch (condition.harmonics) {
+            case HARMONICS_SINE: amplitudes[k - 1] = k == 1 ? 1.0f : 0.0f; break;
+            case HARMONICS_SAW: amplitudes[k - 1] = 1.0f / k; break;
+            case HARMONICS_ODD: amplitudes[k - 1] = k % 2 ? 1.0f / k : 0.0f; break;
+            case HARMONICS_WEAK: amplitudes[k - 1] = k == 1 ? 0.15f : k <= 3 ? 1.0f / (k - 1) : 0.5f / k; break;
+        }
+        phases[k - 1] = phaseDistribution(generator);
+        harmonicCount = k;
+    }
+    float power = 0.0f;
+    for (int k = 0; k < harmonicCount; k++) power += 0.5f * amplitudes[k] * amplitudes[k];
+    float sum = 0.0f;
+    for (int k = 0; k < harmonicCount; k++) sum += amplitudes[k];
+    float scale = 0.5f / sum;
+    float noiseLevel = std::isinf(condition.snr) ? 0.0f : sqrtf(power / powf(10.0f, condition.snr / 10.0f)) * scale;
+
+    out.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        float t = (float) i / condition.sampleRate;
+        float value = 0.0f;
+        for (int k = 0; k < harmonicCount; k++) {
+            value += amplitudes[k] * sinf(2.0f * (float) M_PI * (k + 1) * frequency * t + phases[k]);
+        }
+        value = value * scale + noiseLevel * noise(generator);
+        value = std::max(-1.0f, std::min(1.0f, value));
+        out[i] = (int16_t) (value * INT16_MAX);
+    }
+}
+
+static float randomFrequency(const Condition& condition) {
+    std::uniform_real_distribution<float> distribution(log2f(condition.minFrequency), log2f(condition.maxFrequency));
+    return exp2f(distribution(generator));
+}
+
+static void runFixed(const Condition& condition, int trials, Result& result) {
+    Yin_Fixed* yin = yin_fixed_new(condition.sampleRate, condition.bufferSize);
+    std::vector<int16_t> buffer;
+    for (int i = 0; i < trials; i++) {
+        float frequency = randomFrequency(condition);
+        generate(condition, frequency, buffer, condition.bufferSize);
+        auto start = std::chrono::steady_clock::now();
+        float pitch = yin_fixed_estimate_pitch(yin, buffer.data());
+        result.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        result.add(pitch, yin_fixed_last_pitch_estimate_probability(yin), frequency);
+    }
+    yin_fixed_destroy(yin);
+}
+
+// the estimates of a few hops after the window has filled
+static void runStream(const Condition& condition, int trials, Result& result) {
+    static const int EstimatesPerTrial = 4;
+    static Yin_Stream yin;
+    std::vector<int16_t> signal;
+    for (int i = 0; i < trials; i++) {
+        float frequency = randomFrequency(condition);
+        generate(condition, frequency, signal, 2 * YIN_STREAM_WINDOW_SIZE + EstimatesPerTrial * YIN_STREAM_HOP_SIZE);
+        yin_stream_init(&yin, condition.sampleRate);
+        for (size_t start = 0; start + YIN_STREAM_HOP_SIZE <= signal.size(); start += YIN_STREAM_HOP_SIZE) {
+            auto begin = std::chrono::steady_clock::now();
+            float pitch = yin_stream_push_hop(&yin, &signal[start]);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+            if (start + YIN_STREAM_HOP_SIZE > 2 * YIN_STREAM_WINDOW_SIZE) {
+                result.ns += ns;
+                result.add(pitch, yin_stream_last_pitch_estimate_probability(&yin), frequency);
+            }
+        }
+    }
+}
+
+// yin_fixed's estimate with the direct O(N^2) difference function it had
+// before the FFT, on the same threshold and interpolation
+static float directEstimate(const int16_t* buffer, size_t bufferSize, float sampleRate, float* probability) {
+    size_t w = bufferSize / 2;
+    std::vector<int32_t> difference(w, 0);
+    for (size_t tau = 0; tau < w; tau++) {
+        for (size_t j = 0; j < w; j++) {
+            fixed_point delta = fixed_point_sum(buffer[j], -buffer[j + tau]);
+            difference[tau] += fixed_point_mul(delta, delta);
+        }
+    }
+    int tau = yin_absolute_threshold(difference.data(), w, 0.15f, probability);
+    if (tau < 0) return -1.0f;
+    return sampleRate / yin_parabolic_interpolation(difference.data(), w, tau);
+}
+
+// Sines of amplitude 0.5 from phase 0, as yin/fixedpoint_math.c makes them,
+// through the FFT and the direct difference function: the largest pitch and
+// probability differences and the estimates that disagree on voicing.
+static void compareDirect() {
+    const float rates[] = { 8000.0f, 16000.0f, 44100.0f };
+    const int sizes[] = { 1024, 2048 };
+    printf("\n== FFT against direct difference function (sines of 0.5 from 82 Hz to 1760 Hz, and 471 Hz)\n");
+    printf("%-22s %6s %12s %12s %9s\n", "condition", "n", "max dHz", "max dprob", "voicing");
+    for (float rate : rates) {
+        for (int size : sizes) {
+            Yin_Fixed* yin = yin_fixed_new(rate, size);
+            std::vector<int16_t> buffer(size);
+            float maxPitch = 0.0f, maxProbability = 0.0f;
+            int count = 0, voicing = 0;
+            // semitones from E2 to A6, then fixedpoint_math.c's own tone
+            for (int semitone = 0; semitone <= 52; semitone++) {
+                float frequency = semitone < 52 ? 82.41f * exp2f(semitone / 12.0f) : 471.0f;
+                float angular = 2.0f * (float) M_PI * frequency / rate;
+                for (int i = 0; i < size; i++) {
+                    buffer[i] = (int16_t) (0.5f * sinf(angular * i) * INT16_MAX);
+                }
+                float fftPitch = yin_fixed_estimate_pitch(yin, buffer.data());
+                float fftProbability = yin_fixed_last_pitch_estimate_probability(yin);
+                float directProbability;
+                float directPitch = directEstimate(buffer.data(), size, rate, &directProbability);
+                count++;
+                if ((fftPitch > 0) != (directPitch > 0)) {
+                    voicing++;
+                    continue;
+                }
+                if (fftPitch > 0) maxPitch = std::max(maxPitch, fabsf(fftPitch - directPitch));
+                maxProbability = std::max(maxProbability, fabsf(fftProbability - directProbability));
+            }
+            yin_fixed_destroy(yin);
+            char label[64];
+            snprintf(label, sizeof(label), "%.0f Hz, %d samples", rate, size);
+            printf("%-22s %6d %12.4f %12.5f %9d\n", label, count, maxPitch, maxProbability, voicing);
+        }
+    }
+}
+
+static float percentile(std::vector<float>& values, float p) {
+    if (values.empty()) return NAN;
+    std::sort(values.begin(), values.end());
+    return values[(size_t) (p * (values.size() - 1))];
+}
+
+static void print(const char* label, const char* variant, Result& result) {
+    float n = result.estimates > 0 ? (float) result.estimates : 1.0f;
+    printf("%-22s %-7s %6d %7.1f%% %7.2f %7.2f %7.1f%% %7.1f%% %9.0f\n", label, variant, result.estimates,
+        100.0f * result.voiced / n, percentile(result.errors, 0.5f), percentile(result.errors, 0.95f),
+        100.0f * result.octave / n, 100.0f * result.gross / n, result.ns / n);
+}
+
+static void header(const char* title) {
+    printf("\n== %s\n%-22s %-7s %6s %8s %7s %7s %8s %8s %9s\n", title, "condition", "yin", "n", "voiced",
+        "median", "p95", "octave", "gross", "ns");
+}
+
+// the stream's lowest pitch is fixed by its compiled window
+static bool streamFits(const Condition& condition) {
+    return condition.minFrequency * 1.1f > condition.sampleRate / YIN_STREAM_WINDOW_SIZE;
+}
+
+static void run(const char* label, const Condition& condition, int trials, Result& fixedTotal, Result& streamTotal) {
+    Result fixed;
+    runFixed(condition, trials, fixed);
+    print(label, "fixed", fixed);
+    fixedTotal.merge(fixed);
+    if (streamFits(condition)) {
+        Result stream;
+        runStream(condition, trials, stream);
+        print(label, "stream", stream);
+        streamTotal.merge(stream);
+    }
+}
+
+static void printCalibration(const char* variant, const Result& result) {
+    printf("%-7s", variant);
+    for (int i = 0; i < CalibrationBins; i++) {
+        if (result.calibrationCount[i] == 0) {
+            printf("        -      ");
+        } else {
+            printf(" %6.1f%% (%5d)", 100.0f * result.calibrationRight[i] / result.calibrationCount[i], result.calibrationCount[i]);
+        }
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    int trials = 200;
+    unsigned seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--trials") == 0) trials = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (unsigned) atoi(argv[i + 1]);
+    }
+    generator.seed(seed);
+
+    test_fixed_point_math();
+    printf("fixed point arithmetic checks passed\n");
+    compareDirect();
+    printf("stream window %d, hop %d samples\n", YIN_STREAM_WINDOW_SIZE, YIN_STREAM_HOP_SIZE);
+
+    Result fixedTotal;
+    Result streamTotal;
+    char label[64];
+    const Condition base = { 16000.0f, 1024, 60.0f, 1600.0f, HARMONICS_SAW, 40.0f };
+
+    header("frequency (16 kHz, 1024 samples, saw, 40 dB SNR)");
+    const float bands[] = { 60.0f, 120.0f, 240.0f, 480.0f, 960.0f, 1600.0f };
+    for (int i = 0; i + 1 < (int) (sizeof(bands) / sizeof(bands[0])); i++) {
+        Condition condition = base;
+        condition.minFrequency = bands[i];
+        condition.maxFrequency = bands[i + 1];
+        snprintf(label, sizeof(label), "%.0f-%.0f Hz", bands[i], bands[i + 1]);
+        run(label, condition, trials, fixedTotal, streamTotal);
+    }
+
+    header("buffer size (16 kHz, 2.5 periods to 1600 Hz, saw, 40 dB SNR)");
+    const int sizes[] = { 256, 512, 1024, 2048, 4096 };
+    for (int size : sizes) {
+        Condition condition = base;
+        condition.bufferSize = size;
+        condition.minFrequency = std::max(60.0f, 2.5f * condition.sampleRate / size);
+        Result fixed;
+        runFixed(condition, trials, fixed);
+        snprintf(label, sizeof(label), "%d (%.0f Hz up)", size, condition.minFrequency);
+        print(label, "fixed", fixed);
+        fixedTotal.merge(fixed);
+    }
+
+    header("sample rate (1024 samples, 100-1600 Hz, saw, 40 dB SNR)");
+    const float rates[] = { 8000.0f, 16000.0f, 22050.0f, 44100.0f };
+    for (float rate : rates) {
+        Condition condition = base;
+        condition.sampleRate = rate;
+        condition.minFrequency = std::max(100.0f, 2.5f * rate / condition.bufferSize);
+        snprintf(label, sizeof(label), "%.0f Hz (%.0f Hz up)", rate, condition.minFrequency);
+        run(label, condition, trials, fixedTotal, streamTotal);
+    }
+
+    header("noise (16 kHz, 1024 samples, 80-1600 Hz, saw)");
+    const float snrs[] = { INFINITY, 40.0f, 30.0f, 20.0f, 10.0f, 5.0f, 0.0f };
+    for (float snr : snrs) {
+        Condition condition = base;
+        condition.minFrequency = 80.0f;
+        condition.snr = snr;
+        if (std::isinf(snr)) snprintf(label, sizeof(label), "no noise");
+        else snprintf(label, sizeof(label), "%.0f dB SNR", snr);
+        run(label, condition, trials, fixedTotal, streamTotal);
+    }
+
+    header("harmonics (16 kHz, 1024 samples, 80-1600 Hz, 40 dB SNR)");
+    for (int harmonics = 0; harmonics < HARMONICS_COUNT; harmonics++) {
+        Condition condition = base;
+        condition.minFrequency = 80.0f;
+        condition.harmonics = harmonics;
+        run(HarmonicsNames[harmonics], condition, trials, fixedTotal, streamTotal);
+    }
+
+    printf("\n== probability calibration, right estimates (count) per reported probability\n%-7s", "yin");
+    for (int i = 0; i < CalibrationBins; i++) {
+        printf("   %.2f-%.2f    ", CalibrationEdges[i], std::min(1.0f, CalibrationEdges[i + 1]));
+    }
+    printf("\n");
+    printCalibration("fixed", fixedTotal);
+    printCalibration("stream", streamTotal);
+    return 0;
+}
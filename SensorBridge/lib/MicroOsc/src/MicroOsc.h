@@ -68,6 +68,12 @@ public:
 	*/
 	void parseMessages(tOscCallbackFunction callback , unsigned char *buffer, const size_t len);
 
+	/**
+	* Returns the time tag of the bundle that is currently being parsed.
+	* Returns 0 if the message was not part of a bundle.
+	*/
+	uint64_t getBundleTimeTag() { return timetag; }
+
 private:
 
 
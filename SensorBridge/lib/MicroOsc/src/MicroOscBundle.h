@@ -0,0 +1,97 @@
+/* MicroOscBundle
+ * Buffer backed OSC bundle writer.
+ * Messages are appended with the regular MicroOsc send and write functions,
+ * the finished bundle can then be sent as a single packet.
+ */
+
+#ifndef _MICRO_OSC_BUNDLE_
+#define _MICRO_OSC_BUNDLE_
+
+#include <MicroOsc.h>
+#include "MicroOscUtility.h"
+
+
+template <const size_t MICRO_OSC_OUT_SIZE>
+class MicroOscBundle : public MicroOsc {
+
+    class BundleBuffer : public Print {
+      public:
+        unsigned char data[MICRO_OSC_OUT_SIZE];
+        size_t length = 0;
+        bool overflow = false;
+
+        size_t write(uint8_t b) {
+          if (length >= MICRO_OSC_OUT_SIZE) {
+            overflow = true;
+            return 0;
+          }
+          data[length++] = b;
+          return 1;
+        }
+
+        size_t write(const uint8_t *b, size_t size) {
+          if (length + size > MICRO_OSC_OUT_SIZE) {
+            overflow = true;
+            return 0;
+          }
+          memcpy(data + length, b, size);
+          length += size;
+          return size;
+        }
+    };
+
+    BundleBuffer buffer;
+    size_t elementStart = 0; // offset of the size field of the element being written
+    size_t elementCount = 0;
+
+  public:
+    MicroOscBundle() : MicroOsc(&buffer) {
+      begin(OSC_BUNDLE_TIMETAG_IMMEDIATELY);
+    }
+
+    static const uint64_t OSC_BUNDLE_TIMETAG_IMMEDIATELY = 1ULL;
+
+    /**
+    * Clear the buffer and start a new bundle with the given time tag.
+    */
+    void begin(uint64_t timeTag) {
+      static const char header[8] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', '\0'};
+      buffer.length = 0;
+      buffer.overflow = false;
+      elementCount = 0;
+      buffer.write((const uint8_t *) header, sizeof(header));
+      const uint64_t timeTagBE = uOsc_bigEndian(timeTag);
+      buffer.write((const uint8_t *) &timeTagBE, sizeof(timeTagBE));
+    }
+
+    virtual void beginMessage() {
+      elementStart = buffer.length;
+      const uint32_t placeholder = 0;
+      buffer.write((const uint8_t *) &placeholder, 4);
+    }
+
+    virtual void endMessage() {
+      if (buffer.overflow) {
+        // drop the element that did not fit, keep the rest of the bundle
+        buffer.length = elementStart;
+        buffer.overflow = false;
+        return;
+      }
+      const uint32_t sizeBE = uOsc_bigEndian((uint32_t) (buffer.length - elementStart - 4));
+      memcpy(buffer.data + elementStart, &sizeBE, 4);
+      elementCount++;
+    }
+
+    bool readyToSendMessage() {
+      return buffer.length + 4 < MICRO_OSC_OUT_SIZE;
+    }
+
+    // Bundles are write only
+    virtual void onOscMessageReceived(tOscCallbackFunction callback) { }
+
+    const unsigned char * data() const { return buffer.data; }
+    size_t size() const { return buffer.length; }
+    size_t messageCount() const { return elementCount; }
+};
+
+#endif // _MICRO_OSC_BUNDLE_
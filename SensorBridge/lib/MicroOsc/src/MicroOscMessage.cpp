@@ -14,6 +14,15 @@ int32_t MicroOscMessage::nextAsInt() {
   return i;
 }
 
+int64_t MicroOscMessage::nextAsInt64() {
+  // arguments are only 4 byte aligned, copy before converting
+  int64_t iBE;
+  memcpy(&iBE, marker, sizeof(int64_t));
+  const int64_t i = uOsc_bigEndian(iBE);
+
+  marker += 8;
+  return i;
+}
 
 float MicroOscMessage::nextAsFloat() {
   // convert from big-endian (network btye order)
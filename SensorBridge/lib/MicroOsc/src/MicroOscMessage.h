@@ -81,6 +81,12 @@ public:
 	 */
 	int32_t nextAsInt();
 
+	/**
+	 * Returns the next argument as a 64-bit int.
+	 * Does not check buffer bounds.
+	 */
+	int64_t nextAsInt64();
+
 	/**
 	 * Returns the next argument as a 32-bit float.
 	 * Does not check buffer bounds.
@@ -31,4 +31,22 @@ static inline T uOsc_bigEndian(const T& x)
   }
   return ret;
 }
+
+/*
+ OSC time tags are 32.32 fixed point seconds. Devices without an absolute
+ clock use them relative to boot, so these convert from and to microseconds.
+ */
+static inline uint64_t uOsc_microsToTimeTag(uint64_t micros)
+{
+  uint64_t seconds = micros / 1000000ULL;
+  uint64_t fraction = ((micros % 1000000ULL) << 32) / 1000000ULL;
+  return (seconds << 32) | fraction;
+}
+
+static inline uint64_t uOsc_timeTagToMicros(uint64_t timeTag)
+{
+  uint64_t seconds = timeTag >> 32;
+  uint64_t fraction = timeTag & 0xFFFFFFFFULL;
+  return seconds * 1000000ULL + ((fraction * 1000000ULL + 0x80000000ULL) >> 32);
+}
 #endif
\ No newline at end of file
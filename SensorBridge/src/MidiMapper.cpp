@@ -0,0 +1,217 @@
+#include "MidiMapper.h"
+
+MidiMapper::MidiMapper()
+  : activeCount(0), pendingOffCount(0), channel(0), tapNoteNumber(60), doubleTapNoteNumber(62), onsetNoteNumber(128),
+    lastProcessTime(0) {
+  SoundingNote none = { };
+  hitNote = none;
+  onsetNote = none;
+  for (int i = 0; i < imu::GestureRecognizer::MaxTemplates; i++) {
+    gestureMidi[i].status = 0x90;
+    gestureMidi[i].data = 72 + i;
+  }
+  resetMappings();
+}
+
+bool MidiMapper::setMapping(int slot, const Mapping& mapping) {
+  if (slot < 0 || slot >= MaxMappings) return false;
+  retireNote(slot);
+  mappings[slot] = mapping;
+  bool valid = compiled[slot].compile(mapping);
+  if (!valid) {
+    mappings[slot].target = TARGET_NONE;
+  }
+  updateActiveMappings();
+  return valid;
+}
+
+void MidiMapper::clearMapping(int slot) {
+  Mapping none = { };
+  setMapping(slot, none);
+}
+
+void MidiMapper::resetMappings() {
+  for (int i = 0; i < MaxMappings; i++) {
+    Mapping none = { };
+    retireNote(i);
+    mappings[i] = none;
+    compiled[i].compile(none);
+  }
+  // CC 80 - 82 are custom CCs for pitch, jaw and roll
+  for (int i = 0; i < 3; i++) {
+    Mapping mapping = { };
+    mapping.source = SOURCE_PITCH + i;
+    mapping.curve = CURVE_LINEAR;
+    mapping.target = TARGET_CC;
+    mapping.number = 80 + i;
+    mapping.min = -90.0f;
+    mapping.max = 90.0f;
+    // at rest the CCs stop flickering, a 100 deg/s move raises the cutoff to 3 Hz
+    mapping.minCutoff = 1.0f;
+    mapping.beta = 0.02f;
+    mappings[i] = mapping;
+    compiled[i].compile(mapping);
+  }
+  updateActiveMappings();
+}
+
+void MidiMapper::retireNote(int slot) {
+  CompiledMapping& mapping = compiled[slot];
+  if (mapping.isActive() && mapping.target == TARGET_NOTE && mapping.lastNote >= 0
+      && pendingOffCount < MaxMappings) {
+    pendingOffs[pendingOffCount][0] = mapping.status & 0xEF;
+    pendingOffs[pendingOffCount][1] = (uint8_t) mapping.lastNote;
+    pendingOffCount++;
+  }
+  mapping.lastNote = -1;
+}
+
+void MidiMapper::updateActiveMappings() {
+  activeCount = 0;
+  for (int i = 0; i < MaxMappings; i++) {
+    if (compiled[i].isActive()) {
+      active[activeCount++] = i;
+    }
+  }
+}
+
+void MidiMapper::setTapNotes(uint8_t note, uint8_t doubleTapNote) {
+  tapNoteNumber = note;
+  doubleTapNoteNumber = doubleTapNote;
+}
+
+bool MidiMapper::processTap(const imu::TapEvent& tap, StreamOptions mode, MidiOutFunction out) {
+  if (mode != STREAM_TAP && mode != STREAM_PITCH_JAW_ROLL_TAP) {
+    return false;
+  }
+  playNote(hitNote, tap.count >= 2 ? doubleTapNoteNumber : tapNoteNumber, tap.velocity, tap.timestamp, out);
+  return true;
+}
+
+bool MidiMapper::processOnset(const audio::OnsetEvent& onset, StreamOptions mode, MidiOutFunction out) {
+  if ((mode != STREAM_TAP && mode != STREAM_PITCH_JAW_ROLL_TAP) || onsetNoteNumber > 127) {
+    return false;
+  }
+  playNote(onsetNote, onsetNoteNumber, onset.velocity, onset.timestamp, out);
+  return true;
+}
+
+void MidiMapper::setGestureMidi(int slot, const GestureMidi& midi) {
+  if (slot < 0 || slot >= imu::GestureRecognizer::MaxTemplates) return;
+  gestureMidi[slot] = midi;
+}
+
+bool MidiMapper::processGesture(const imu::GestureEvent& gesture, StreamOptions mode, MidiOutFunction out) {
+  if (mode == STEAM_OFF || gesture.recorded || gesture.gesture >= imu::GestureRecognizer::MaxTemplates) {
+    return false;
+  }
+  const GestureMidi& midi = gestureMidi[gesture.gesture];
+  switch (midi.status) {
+    case 0x90:
+      playNote(hitNote, midi.data, 100, gesture.timestamp, out);
+      return true;
+    case 0xC0:
+      out(0xC0 + channel, midi.data, 0);
+      return true;
+    default:
+      return false;
+  }
+}
+
+void MidiMapper::playNote(SoundingNote& sounding, uint8_t note, uint8_t velocity, int64_t timestamp, MidiOutFunction out) {
+  // a new hit cuts the previous note
+  releaseNote(sounding, out);
+  sounding.channel = channel;
+  sounding.number = note;
+  out(0x90 + sounding.channel, sounding.number, velocity);
+  sounding.offTime = timestamp + NoteLength;
+  sounding.isOn = true;
+}
+
+void MidiMapper::releaseNote(SoundingNote& sounding, MidiOutFunction out) {
+  if (!sounding.isOn) return;
+  out(0x80 + sounding.channel, sounding.number, 0);
+  sounding.isOn = false;
+}
+
+int64_t MidiMapper::getNoteReleaseTime() const {
+  if (hitNote.isOn && (!onsetNote.isOn || hitNote.offTime <= onsetNote.offTime)) return hitNote.offTime;
+  return onsetNote.isOn ? onsetNote.offTime : 0;
+}
+
+void MidiMapper::releaseNote(MidiOutFunction out) {
+  if (hitNote.isOn && (!onsetNote.isOn || hitNote.offTime <= onsetNote.offTime)) {
+    releaseNote(hitNote, out);
+  } else {
+    releaseNote(onsetNote, out);
+  }
+}
+
+bool MidiMapper::streams(StreamOptions mode, uint8_t source) {
+  switch (mode) {
+    case STREAM_PITCH_JAW_ROLL_TAP: return true;
+    case STREAM_PITCH: return source == SOURCE_PITCH;
+    case STREAM_JAW: return source == SOURCE_JAW;
+    case STREAM_ROLL: return source == SOURCE_ROLL;
+    default: return false;
+  }
+}
+
+void MidiMapper::process(const imu::ImuData& imuData, StreamOptions mode, MidiOutFunction out) {
+  float sources[SOURCE_COUNT];
+  readImuSources(imuData, sources);
+  process(sources, imuData.timestamp, mode, out);
+}
+
+void MidiMapper::process(const float* sources, int64_t timestamp, StreamOptions mode, MidiOutFunction out) {
+  float dt = lastProcessTime != 0 ? (timestamp - lastProcessTime) * 1e-6f : 0.0f;
+  lastProcessTime = timestamp;
+
+  // notes of slots that were set again meanwhile
+  for (int i = 0; i < pendingOffCount; i++) {
+    out(pendingOffs[i][0], pendingOffs[i][1], 0);
+  }
+  pendingOffCount = 0;
+
+  for (int i = 0; i < activeCount; i++) {
+    CompiledMapping& mapping = compiled[active[i]];
+    if (!streams(mode, mapping.source)) {
+      // a note must not hang when its source stops streaming
+      if (mapping.lastNote >= 0) {
+        out(mapping.status & 0xEF, (uint8_t) mapping.lastNote, 0);
+        mapping.lastNote = -1;
+      }
+      mapping.lastValue = 0xFFFF;
+      continue;
+    }
+    float x = sources[mapping.source];
+    if (mapping.smooth) {
+      x = mapping.smoothing.filter(x, dt);
+    }
+    uint16_t value = mapping.lookup(x);
+    if (mapping.target != TARGET_NOTE) {
+      if (value == mapping.lastValue && ++mapping.unchangedFrames < RefreshFrames) {
+        continue;
+      }
+      mapping.lastValue = value;
+      mapping.unchangedFrames = 0;
+    }
+    switch (mapping.target) {
+      case TARGET_CC:
+        out(mapping.status, mapping.number, (uint8_t) value);
+        break;
+      case TARGET_PITCH_BEND:
+        out(mapping.status, value & 0x7F, value >> 7);
+        break;
+      case TARGET_NOTE:
+        if (value != mapping.lastNote) {
+          if (mapping.lastNote >= 0) {
+            out(mapping.status & 0xEF, (uint8_t) mapping.lastNote, 0);
+          }
+          out(mapping.status, (uint8_t) value, 100);
+          mapping.lastNote = value;
+        }
+        break;
+    }
+  }
+}
@@ -0,0 +1,135 @@
+#ifndef MIDIMAPPER_H
+#define MIDIMAPPER_H
+
+#include <stdint.h>
+#include "imu/ImuData.h"
+#include "imu/TapDetector.h"
+#include "imu/GestureRecognizer.h"
+#include "audio/OnsetDetector.h"
+#include "MidiMapping.h"
+
+//stream modes, button A steps through them
+enum StreamOptions {
+  STREAM_PITCH_JAW_ROLL_TAP,
+  STREAM_PITCH,
+  STREAM_JAW,
+  STREAM_ROLL,
+  STREAM_TAP,
+  STEAM_OFF,
+  COUNT //helper to track size
+};
+
+inline StreamOptions nextStreamMode(StreamOptions c) {
+    return static_cast<StreamOptions>((static_cast<int>(c) + 1) % static_cast<int>(StreamOptions::COUNT));
+}
+
+// receives the MIDI messages the mapper produces
+typedef void (*MidiOutFunction)(uint8_t status, uint8_t data1, uint8_t data2);
+
+// what a recognized gesture plays, on the mapper's channel
+struct GestureMidi {
+  uint8_t status;   // 0x90 note, 0xC0 program change, 0 nothing
+  uint8_t data;     // note or program number
+};
+
+/*
+ * Turns IMU data into MIDI: a note for a tap and a configurable set of
+ * mappings from sources (orientation, acceleration, ...) to CCs, notes or
+ * pitch bend, by default CC 80/81/82 for pitch, jaw and roll. process() is
+ * called at the main loop rate with the latest frame, processTap() and
+ * processGesture() for every tap and gesture the IMU task found,
+ * processOnset() for every sound the audio task heard start. Taps and
+ * gestures share one sounding note, the next one cuts it; onsets have
+ * their own, so a tap's knock does not cut the tap's note.
+ * Has no hardware or Arduino dependencies so the host replay tool
+ * (bench/imu_replay.cpp) produces exactly the stream the device sends.
+ */
+class MidiMapper {
+public:
+  MidiMapper();
+
+  void setChannel(uint8_t channel) { this->channel = channel; }
+  uint8_t getChannel() const { return channel; }
+  // notes for single and double (or more) taps
+  void setTapNotes(uint8_t note, uint8_t doubleTapNote);
+  uint8_t getTapNote() const { return tapNoteNumber; }
+  uint8_t getDoubleTapNote() const { return doubleTapNoteNumber; }
+
+  // Source to MIDI mappings, compiled into lookup tables when set. A note
+  // sounding from a slot that is set again gets its note off on the next
+  // process().
+  static const int MaxMappings = 16;
+  // false when the mapping is invalid, the slot then maps nothing
+  bool setMapping(int slot, const Mapping& mapping);
+  const Mapping& getMapping(int slot) const { return mappings[slot]; }
+  void clearMapping(int slot);
+  // CC 80/81/82 for pitch, jaw and roll over -90 - 90 degrees on channel 1,
+  // smoothed at rest
+  void resetMappings();
+
+  // The stream mode selects the mapped sources: all, one orientation axis
+  // or none. sources holds SOURCE_COUNT values sampled at timestamp (us).
+  // CC and pitch bend values are only sent when they change, and once a
+  // second to recover from lost packets.
+  void process(const float* sources, int64_t timestamp, StreamOptions mode, MidiOutFunction out);
+  void process(const imu::ImuData& imuData, StreamOptions mode, MidiOutFunction out);
+
+  // Note on for a tap, velocity from the tap. Returns false when the mode
+  // does not play taps.
+  bool processTap(const imu::TapEvent& tap, StreamOptions mode, MidiOutFunction out);
+
+  // Note on for a sound's onset (a clap, a struck object), velocity from its
+  // level. Plays in the modes that play taps. Off by default, a note above
+  // 127 turns onset notes off.
+  void setOnsetNote(uint8_t note) { onsetNoteNumber = note; }
+  uint8_t getOnsetNote() const { return onsetNoteNumber; }
+  bool processOnset(const audio::OnsetEvent& onset, StreamOptions mode, MidiOutFunction out);
+
+  // by default gesture slot n plays note 72 + n
+  void setGestureMidi(int slot, const GestureMidi& midi);
+  const GestureMidi& getGestureMidi(int slot) const { return gestureMidi[slot]; }
+  // Note on or program change for a matched gesture. Returns false when
+  // nothing is sent.
+  bool processGesture(const imu::GestureEvent& gesture, StreamOptions mode, MidiOutFunction out);
+
+  // Sample time at which the first sounding note ends, 0 when none is
+  // sounding. releaseNote() ends that note.
+  int64_t getNoteReleaseTime() const;
+  void releaseNote(MidiOutFunction out);
+
+private:
+  static const int64_t NoteLength = 100000; // us
+  static const int RefreshFrames = 50;      // unchanged values are sent again after this
+
+  struct SoundingNote {
+    uint8_t channel;    // the note off goes to the same channel, even if it is changed meanwhile
+    uint8_t number;
+    int64_t offTime;
+    bool isOn;
+  };
+
+  void playNote(SoundingNote& sounding, uint8_t note, uint8_t velocity, int64_t timestamp, MidiOutFunction out);
+  static void releaseNote(SoundingNote& sounding, MidiOutFunction out);
+  void updateActiveMappings();
+  // keeps the note off of a slot's sounding note for the next process()
+  void retireNote(int slot);
+  static bool streams(StreamOptions mode, uint8_t source);
+
+  Mapping mappings[MaxMappings];
+  CompiledMapping compiled[MaxMappings];
+  uint8_t active[MaxMappings];  // slots that map something
+  int activeCount;
+  uint8_t pendingOffs[MaxMappings][2]; // status and note of notes of recompiled slots
+  int pendingOffCount;
+
+  uint8_t channel;
+  uint8_t tapNoteNumber;
+  uint8_t doubleTapNoteNumber;
+  uint8_t onsetNoteNumber;
+  GestureMidi gestureMidi[imu::GestureRecognizer::MaxTemplates];
+  SoundingNote hitNote;     // of taps and gestures
+  SoundingNote onsetNote;
+  int64_t lastProcessTime;  // sample time of the previous frame
+};
+
+#endif // MIDIMAPPER_H
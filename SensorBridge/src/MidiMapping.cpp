@@ -0,0 +1,90 @@
+#include <math.h>
+#include "MidiMapping.h"
+
+void readImuSources(const imu::ImuData& imuData, float* sources) {
+  sources[SOURCE_PITCH] = imuData.orientation[0];
+  sources[SOURCE_JAW] = imuData.orientation[1];
+  sources[SOURCE_ROLL] = imuData.orientation[2];
+  for (int i = 0; i < 3; i++) {
+    sources[SOURCE_ACC_X + i] = imuData.acc[i];
+    sources[SOURCE_GYRO_X + i] = imuData.gyro[i];
+  }
+  sources[SOURCE_TEMPO] = imuData.tempo;
+  sources[SOURCE_TEMPO_PHASE] = imuData.tempoPhase;
+  sources[SOURCE_TEMPO_CONFIDENCE] = imuData.tempoConfidence;
+  sources[SOURCE_MOTION_ENERGY] = imuData.motionEnergy;
+  sources[SOURCE_MOTION_JERK] = imuData.motionJerk;
+  sources[SOURCE_MOTION_FREQUENCY] = imuData.motionFrequency;
+  for (int i = 0; i < 3; i++) {
+    sources[SOURCE_MOTION_BAND_LOW + i] = imuData.motionBands[i];
+  }
+}
+
+bool isAngleSource(uint8_t source) {
+  return source == SOURCE_PITCH || source == SOURCE_JAW || source == SOURCE_ROLL;
+}
+
+// 0 - 1 to 0 - 1
+static float applyCurve(uint8_t curve, float u) {
+  switch (curve) {
+    case CURVE_EXPONENTIAL:
+      return (expf(4.0f * u) - 1.0f) / (expf(4.0f) - 1.0f);
+    case CURVE_S:
+      return u * u * (3.0f - 2.0f * u);
+    default:
+      return u;
+  }
+}
+
+bool CompiledMapping::compile(const Mapping& mapping) {
+  target = TARGET_NONE;
+  lastNote = -1;
+  lastValue = 0xFFFF;
+  unchangedFrames = 0;
+  smooth = false;
+  if (mapping.target == TARGET_NONE) {
+    return true;
+  }
+  if (mapping.source >= SOURCE_COUNT || mapping.curve >= CURVE_COUNT || mapping.target >= TARGET_COUNT
+      || mapping.channel > 15 || mapping.number > 127 || !(mapping.max != mapping.min)) {
+    return false;
+  }
+
+  uint16_t top;
+  switch (mapping.target) {
+    case TARGET_CC:
+      status = 0xB0;
+      top = 127;
+      break;
+    case TARGET_NOTE:
+      status = 0x90;
+      top = mapping.number + mapping.span > 127 ? 127 - mapping.number : mapping.span;
+      break;
+    case TARGET_PITCH_BEND:
+      status = 0xE0;
+      top = 16383;
+      break;
+    default:
+      return false;
+  }
+  status |= mapping.channel;
+  source = mapping.source;
+  number = mapping.number;
+
+  smooth = mapping.minCutoff > 0.0f;
+  smoothing.setParameters(mapping.minCutoff, mapping.beta >= 0.0f ? mapping.beta : 0.0f);
+  smoothing.setWrap(isAngleSource(mapping.source) ? 360.0f : 0.0f);
+  smoothing.reset();
+
+  // min may be above max, the range then runs the other way round
+  offset = mapping.min;
+  scale = (TableSize - 1) / (mapping.max - mapping.min);
+  for (int i = 0; i < TableSize; i++) {
+    float u = applyCurve(mapping.curve, (float) i / (TableSize - 1));
+    if (mapping.invert) u = 1.0f - u;
+    uint16_t value = (uint16_t) (u * top + 0.5f);
+    table[i] = mapping.target == TARGET_NOTE ? mapping.number + value : value;
+  }
+  target = mapping.target;
+  return true;
+}
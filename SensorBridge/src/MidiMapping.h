@@ -0,0 +1,114 @@
+#ifndef MIDIMAPPING_H
+#define MIDIMAPPING_H
+
+#include <stdint.h>
+#include "imu/ImuData.h"
+#include "util/OneEuroFilter.h"
+
+// Values a mapping can read. New sources go at the end, stored mappings
+// refer to them by number.
+enum MappingSource {
+  SOURCE_PITCH,   // orientation, degrees
+  SOURCE_JAW,
+  SOURCE_ROLL,
+  SOURCE_ACC_X,   // g
+  SOURCE_ACC_Y,
+  SOURCE_ACC_Z,
+  SOURCE_GYRO_X,  // deg/s
+  SOURCE_GYRO_Y,
+  SOURCE_GYRO_Z,
+  SOURCE_EXT_0,   // add-on sensor outputs, see sensors/SensorRegistry.h
+  SOURCE_EXT_1,
+  SOURCE_EXT_2,
+  SOURCE_EXT_3,
+  SOURCE_EXT_4,
+  SOURCE_EXT_5,
+  SOURCE_EXT_6,
+  SOURCE_EXT_7,
+  SOURCE_TEMPO,   // BPM of the movement, see imu/TempoTracker.h
+  SOURCE_TEMPO_PHASE,       // 0 - 1 of the beat
+  SOURCE_TEMPO_CONFIDENCE,  // 0 - 1
+  SOURCE_MOTION_ENERGY,     // g, see imu/MotionFeatures.h
+  SOURCE_MOTION_JERK,       // g/s
+  SOURCE_MOTION_FREQUENCY,  // Hz
+  SOURCE_MOTION_BAND_LOW,   // g
+  SOURCE_MOTION_BAND_MID,
+  SOURCE_MOTION_BAND_HIGH,
+  SOURCE_COUNT
+};
+
+enum MappingCurve {
+  CURVE_LINEAR,
+  CURVE_EXPONENTIAL,  // slow start, fine control of small values
+  CURVE_S,            // fine control at both ends
+  CURVE_COUNT
+};
+
+enum MappingTarget {
+  TARGET_NONE,
+  TARGET_CC,
+  TARGET_NOTE,        // the value picks a note, a new note replaces the last one
+  TARGET_PITCH_BEND,
+  TARGET_COUNT
+};
+
+// One source to one MIDI destination. Plain data, stored as is in NVS.
+struct Mapping {
+  uint8_t source;     // MappingSource
+  uint8_t curve;      // MappingCurve
+  uint8_t invert;     // 1: min gives the highest output
+  uint8_t target;     // MappingTarget
+  uint8_t channel;    // 0 - 15
+  uint8_t number;     // controller, or the lowest note
+  uint8_t span;       // notes above the lowest one, TARGET_NOTE only
+  float min;          // source range, values outside are clamped
+  float max;
+  float minCutoff;    // One Euro smoothing at rest, Hz, 0 off
+  float beta;         // cutoff increase per unit/s of the source
+};
+
+// fills sources[SOURCE_COUNT] from an IMU frame
+void readImuSources(const imu::ImuData& imuData, float* sources);
+// angles wrap around at -180 / 180 degrees
+bool isAngleSource(uint8_t source);
+
+/*
+ * A mapping compiled into a lookup table: the range, curve and inversion
+ * are evaluated once for every table entry, so mapping a value costs a
+ * scale, a clamp and an index whatever the curve. The source can be
+ * smoothed first by a One Euro filter.
+ */
+class CompiledMapping {
+public:
+  static const int TableSize = 256;
+
+  CompiledMapping() : target(TARGET_NONE) { }
+
+  // false for a mapping with unknown fields, it then maps nothing
+  bool compile(const Mapping& mapping);
+  bool isActive() const { return target != TARGET_NONE; }
+
+  uint16_t lookup(float value) const {
+    float x = (value - offset) * scale;
+    if (!(x > 0.0f)) return table[0];   // also NaN
+    if (x >= TableSize - 1) return table[TableSize - 1];
+    return table[(int) (x + 0.5f)];
+  }
+
+  uint8_t source;
+  uint8_t target;
+  uint8_t status;     // MIDI status with channel
+  uint8_t number;
+  int16_t lastNote;   // sounding note of a TARGET_NOTE mapping, -1 none
+  uint16_t lastValue; // last CC or pitch bend value sent, 0xFFFF none
+  uint8_t unchangedFrames;
+  bool smooth;
+  OneEuroFilter smoothing;
+
+private:
+  float offset;
+  float scale;
+  uint16_t table[TableSize];  // CC value, note or 14 bit pitch bend
+};
+
+#endif // MIDIMAPPING_H
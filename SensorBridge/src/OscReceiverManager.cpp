@@ -0,0 +1,39 @@
+#include "OscReceiverManager.h"
+
+OscReceiverManager* OscReceiverManager::instance = nullptr;
+
+OscReceiverManager::OscReceiverManager(UDP& udp)
+  : udp(udp), osc(&udp) {
+  instance = this;
+}
+
+void OscReceiverManager::setMessageHandler(MicroOsc::tOscCallbackFunction handler) {
+  messageHandler = handler;
+}
+
+void OscReceiverManager::update() {
+  osc.onOscMessageReceived(onOscMessage);
+}
+
+void OscReceiverManager::onOscMessage(MicroOscMessage& message) {
+  int64_t receiveTime = esp_timer_get_time();
+
+  if (message.checkOscAddressAndTypeTags("/sync", "h")) {
+    instance->handleSyncRequest(message, receiveTime);
+  } else if (instance->messageHandler) {
+    instance->messageHandler(message);
+  } else if (instance->verbose) {
+    Serial.println("Received OSC message with unhandled address");
+  }
+}
+
+void OscReceiverManager::handleSyncRequest(MicroOscMessage& message, int64_t receiveTime) {
+  int64_t requestTime = message.nextAsInt64();
+
+  // reply to the socket the request came from
+  osc.setDestination(udp.remoteIP(), udp.remotePort());
+  int64_t replyTime = esp_timer_get_time();
+  osc.sendMessage("/sync/reply", "hhh", (long long) requestTime, (long long) receiveTime, (long long) replyTime);
+
+  if (verbose) Serial.printf("Sync reply to %s: t1 %lld t2 %lld t3 %lld\n", udp.remoteIP().toString().c_str(), requestTime, receiveTime, replyTime);
+}
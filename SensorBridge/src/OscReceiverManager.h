@@ -0,0 +1,37 @@
+#ifndef OSCRECEIVERMANAGER_H
+#define OSCRECEIVERMANAGER_H
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <esp_timer.h>
+#include <MicroOsc.h>
+#include <MicroOscUdp.h>
+
+// Handles OSC packets that receivers send back to the sender socket.
+// Clock sync requests are answered here, other messages go to the handler.
+class OscReceiverManager {
+private:
+  UDP& udp;
+  MicroOscUdp<256> osc;
+  MicroOsc::tOscCallbackFunction messageHandler = nullptr;
+  bool verbose = false;
+
+  static OscReceiverManager* instance;
+
+  // MicroOsc callbacks are plain functions, dispatch to the instance
+  static void onOscMessage(MicroOscMessage& message);
+
+  // Answer /sync <t1> with /sync/reply <t1> <t2> <t3> (NTP style exchange)
+  void handleSyncRequest(MicroOscMessage& message, int64_t receiveTime);
+
+public:
+  OscReceiverManager(UDP& udp);
+
+  // Handler for all messages that are not handled internally
+  void setMessageHandler(MicroOsc::tOscCallbackFunction handler);
+
+  // Poll the socket, call regularly from the main loop
+  void update();
+};
+
+#endif
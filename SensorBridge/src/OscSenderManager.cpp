@@ -13,6 +13,9 @@ bool OscSenderManager::begin() {
 
   // Initialize UDP for sending
   udp.begin(0); // Use any available port for sending
+
+  // start at a random sequence number so receivers notice a restart
+  sequenceNumber = esp_random();
   if(verbose) Serial.println("OSC Sender Manager initialized");
   return true;
 }
@@ -170,6 +173,43 @@ void OscSenderManager::sendFloatArrayToAll(const char* address, const float* val
   }
 }
 
+void OscSenderManager::beginBundle(int64_t sampleTime) {
+  bundle.begin(uOsc_microsToTimeTag((uint64_t) sampleTime));
+
+  // lets receivers detect lost, reordered and duplicated packets
+  int sequence = (int) sequenceNumber;
+  addIntArrayToBundle("/seq", &sequence, 1);
+}
+
+void OscSenderManager::addIntArrayToBundle(const char* address, const int* values, size_t count) {
+  if (!bundle.readyToSendMessage()) return;
+
+  char format[17];
+  if (count > sizeof(format) - 1) count = sizeof(format) - 1;
+  memset(format, 'i', count);
+  format[count] = '\0';
+
+  bundle.beginMessage();
+  bundle.writeAddress(address);
+  bundle.writeFormat(format);
+  for (size_t i = 0; i < count; i++) {
+    bundle.writeInt(values[i]);
+  }
+  bundle.endMessage();
+}
+
+void OscSenderManager::sendBundleToAll() {
+  if (bundle.messageCount() <= 1) return; // only the sequence number
+  sequenceNumber++;
+
+  for (const auto& receiver : receivers) {
+    udp.beginPacket(receiver.ip, receiver.port);
+    udp.write(bundle.data(), bundle.size());
+    udp.endPacket();
+  }
+  if (verbose) Serial.printf("Sent bundle to %d receivers: %d messages, %d bytes\n", receivers.size(), bundle.messageCount(), bundle.size());
+}
+
 size_t OscSenderManager::getReceiverCount() const {
   return receivers.size();
 }
@@ -7,6 +7,7 @@
 #include <vector>
 #include <MicroOsc.h>
 #include <MicroOscUdp.h>
+#include <MicroOscBundle.h>
 
 struct OscReceiver {
   IPAddress ip;
@@ -20,6 +21,8 @@ private:
   std::vector<OscReceiver> receivers;
   WiFiUDP udp;
   MicroOscUdp<1024> osc;
+  MicroOscBundle<512> bundle;
+  uint32_t sequenceNumber = 0; // of the next bundle that is sent
   bool verbose = false;
   unsigned long lastDiscoveryTime;
   static const unsigned long DISCOVERY_INTERVAL = 3000; // 3 seconds
@@ -49,6 +52,19 @@ public:
 
   void sendFloatArrayToAll(const char* address, const float* values, size_t count);
 
+  // Start a bundle time tagged with a sample time (esp_timer microseconds).
+  // The first element is /seq <n>, n counts up with every bundle sent.
+  void beginBundle(int64_t sampleTime);
+
+  // Append a list of integers to the current bundle
+  void addIntArrayToBundle(const char* address, const int* values, size_t count);
+
+  // Send the current bundle as one packet to all receivers, if it holds messages
+  void sendBundleToAll();
+
+  // Socket used for sending, receivers reply to it
+  WiFiUDP& getUdp() { return udp; }
+
   // Get number of discovered receivers
   size_t getReceiverCount() const;
   
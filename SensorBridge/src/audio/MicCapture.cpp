@@ -0,0 +1,86 @@
+#include <driver/i2s.h>
+#include <esp_timer.h>
+#include "MicCapture.h"
+
+namespace audio {
+
+    static const i2s_port_t Port = I2S_NUM_0;   // only port 0 has PDM
+
+    MicCapture::MicCapture()
+        : running(false), hopSize(0), hopPeriod(0), lastTimestamp(0), overruns(0), lastInput(0.0f), lastOutput(0.0f) {
+    }
+
+    bool MicCapture::begin(uint32_t sampleRate, int hopSize) {
+        end();
+        i2s_config_t config = { };
+        config.mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_PDM);
+        config.sample_rate = sampleRate;
+        config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+        config.channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT;
+        config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+        config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+        config.dma_buf_count = DmaBuffers;
+        config.dma_buf_len = hopSize;
+        if (i2s_driver_install(Port, &config, 0, NULL) != ESP_OK) {
+            return false;
+        }
+        i2s_pin_config_t pins = { };
+        pins.mck_io_num = I2S_PIN_NO_CHANGE;
+        pins.bck_io_num = I2S_PIN_NO_CHANGE;
+        pins.ws_io_num = ClockPin;
+        pins.data_out_num = I2S_PIN_NO_CHANGE;
+        pins.data_in_num = DataPin;
+        if (i2s_set_pin(Port, &pins) != ESP_OK) {
+            i2s_driver_uninstall(Port);
+            return false;
+        }
+        this->hopSize = hopSize;
+        hopPeriod = (int64_t) hopSize * 1000000 / sampleRate;
+        lastTimestamp = 0;
+        overruns = 0;
+        lastInput = 0.0f;
+        lastOutput = 0.0f;
+        running = true;
+        return true;
+    }
+
+    void MicCapture::end() {
+        if (!running) return;
+        i2s_driver_uninstall(Port);
+        running = false;
+    }
+
+    bool MicCapture::read(int16_t* hop, int64_t& timestamp) {
+        if (!running) return false;
+        size_t bytes = 0;
+        if (i2s_read(Port, hop, hopSize * sizeof(int16_t), &bytes, portMAX_DELAY) != ESP_OK
+            || bytes != hopSize * sizeof(int16_t)) {
+            return false;
+        }
+
+        // the DMA buffer completed just before the read returned, unless the
+        // reader was late. Consecutive hops are one period apart on the
+        // microphone's clock, the wake up time only corrects slow drift.
+        int64_t now = esp_timer_get_time();
+        if (lastTimestamp == 0 || now - lastTimestamp > hopPeriod + hopPeriod / 2) {
+            if (lastTimestamp != 0) overruns++;
+            timestamp = now;
+        } else {
+            timestamp = lastTimestamp + hopPeriod + (now - lastTimestamp - hopPeriod) / 16;
+        }
+        lastTimestamp = timestamp;
+
+        // DC removal (a high-pass at about 10 Hz) and gain
+        for (int i = 0; i < hopSize; i++) {
+            float input = hop[i];
+            lastOutput = input - lastInput + 0.996f * lastOutput;
+            lastInput = input;
+            float value = lastOutput * Gain;
+            if (value > 32767.0f) value = 32767.0f;
+            if (value < -32768.0f) value = -32768.0f;
+            hop[i] = (int16_t) value;
+        }
+        return true;
+    }
+
+} // audio
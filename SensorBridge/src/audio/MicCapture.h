@@ -0,0 +1,46 @@
+#ifndef __AUDIO_MIC_CAPTURE_H__
+#define __AUDIO_MIC_CAPTURE_H__
+
+#include <Arduino.h>
+
+namespace audio {
+
+// Reads the M5StickC Plus2's built-in PDM microphone through I2S DMA.
+// The DMA fills two buffers of one hop each: one is filled while the
+// reading task works on the other, a task late by more than a hop loses
+// audio, which is counted. The DC offset is removed and a fixed gain
+// applied so that quiet sounds keep their resolution in the fixed point
+// pitch estimation.
+class MicCapture {
+public:
+    static const int ClockPin = 0;
+    static const int DataPin = 34;
+    static const int DmaBuffers = 2;
+    static const int Gain = 16;
+
+    MicCapture();
+
+    bool begin(uint32_t sampleRate, int hopSize);
+    void end();
+
+    // Blocks until the next hop of hopSize samples is captured. timestamp is
+    // the capture time of its last sample (esp_timer us), steady from hop
+    // to hop as it follows the microphone's clock.
+    bool read(int16_t* hop, int64_t& timestamp);
+
+    // hops lost because the reader was late
+    uint32_t getOverrunCount() const { return overruns; }
+
+private:
+    bool running;
+    int hopSize;
+    int64_t hopPeriod;      // us
+    int64_t lastTimestamp;
+    uint32_t overruns;
+    float lastInput;        // DC removal state
+    float lastOutput;
+};
+
+} // audio
+
+#endif // __AUDIO_MIC_CAPTURE_H__
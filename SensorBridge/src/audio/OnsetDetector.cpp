@@ -0,0 +1,66 @@
+#include <math.h>
+#include "OnsetDetector.h"
+
+namespace audio {
+
+    OnsetDetector::OnsetDetector() : sampleRate(16000.0f), threshold(9.0f) {
+        reset();
+    }
+
+    void OnsetDetector::begin(float sampleRate) {
+        this->sampleRate = sampleRate;
+        reset();
+    }
+
+    void OnsetDetector::reset() {
+        for (int i = 0; i < HistoryBlocks; i++) {
+            history[i] = -100.0f;
+        }
+        historyIndex = 0;
+        averageRise = 0.0f;
+        lastOnset = INT64_MIN / 2;
+    }
+
+    bool OnsetDetector::process(const int16_t* samples, int count, int64_t timestamp, OnsetEvent& event) {
+        bool found = false;
+        for (int start = 0; start + BlockSize <= count; start += BlockSize) {
+            float energy = 0.0f;
+            for (int i = start; i < start + BlockSize; i++) {
+                energy += (float) samples[i] * samples[i];
+            }
+            // RMS against full scale
+            float level = 10.0f * log10f(energy * (1.0f / (BlockSize * 32768.0f * 32768.0f)) + 1e-10f);
+
+            float reference = history[0];
+            for (int i = 1; i < HistoryBlocks; i++) {
+                if (history[i] < reference) reference = history[i];
+            }
+            float rise = level - reference;
+            history[historyIndex] = level;
+            historyIndex = (historyIndex + 1) % HistoryBlocks;
+
+            int64_t blockStart = timestamp - (int64_t) ((count - start) * 1e6f / sampleRate);
+            bool onset = !found && level >= GateLevel && rise > threshold + AdaptiveFactor * averageRise
+                && blockStart - lastOnset >= Refractory;
+            // the adaptive part follows the rises of everything but the onsets
+            if (!onset && level >= GateLevel) {
+                averageRise += AdaptiveRate * ((rise > 0.0f ? rise : 0.0f) - averageRise);
+            }
+            if (onset) {
+                lastOnset = blockStart;
+                event.timestamp = blockStart;
+                event.level = level;
+                found = true;
+            } else if (found && level > event.level) {
+                // an attack takes a few blocks, the rest of the hop comes at no extra delay
+                event.level = level;
+            }
+        }
+        if (found) {
+            int velocity = (int) ((event.level - GateLevel) * (126.0f / -GateLevel) + 1.5f);
+            event.velocity = (uint8_t) (velocity > 127 ? 127 : velocity);
+        }
+        return found;
+    }
+
+} // audio
@@ -0,0 +1,57 @@
+#ifndef __AUDIO_ONSET_DETECTOR_H__
+#define __AUDIO_ONSET_DETECTOR_H__
+
+#include <stdint.h>
+
+namespace audio {
+
+struct OnsetEvent {
+    int64_t timestamp;  // capture time of the block the sound started in, us
+    float level;        // dBFS, loudest block from there to the end of its hop
+    uint8_t velocity;   // 1 - 127, from the level
+};
+
+// Finds the attacks of sounds (claps, struck objects, plucked or sung
+// notes) in the microphone stream, in blocks of 2 ms at 16 kHz. The
+// detection function is the rise of a block's energy over the quietest of
+// the blocks just before, so an attack spread over a few blocks still
+// counts in full. An onset needs a rise of threshold dB plus an adaptive
+// part that follows the recent rises, so a noisy or busy room raises the
+// bar. The event carries the block's time and is found within the hop it
+// is in, one hop (8 ms) after the sound started at most.
+class OnsetDetector {
+public:
+    static const int BlockSize = 32;    // samples
+
+    OnsetDetector();
+
+    void begin(float sampleRate);
+    // rise of the level over the blocks before, dB
+    void setThreshold(float threshold) { this->threshold = threshold; }
+    float getThreshold() const { return threshold; }
+
+    void reset();
+
+    // count samples, a multiple of BlockSize, the last one captured at
+    // timestamp. Returns true and fills event for an onset; the refractory
+    // time is longer than a hop, there is at most one.
+    bool process(const int16_t* samples, int count, int64_t timestamp, OnsetEvent& event);
+
+private:
+    static const int HistoryBlocks = 8;             // the reference level, 16 ms
+    static constexpr float GateLevel = -45.0f;      // dBFS, quieter blocks start nothing
+    static constexpr float AdaptiveFactor = 1.5f;   // of the average rise
+    static constexpr float AdaptiveRate = 0.01f;    // per block, about 200 ms
+    static const int64_t Refractory = 50000;        // us, ringing of the same sound
+
+    float sampleRate;
+    float threshold;
+    float history[HistoryBlocks];   // levels of the blocks before, dBFS
+    int historyIndex;
+    float averageRise;
+    int64_t lastOnset;
+};
+
+} // audio
+
+#endif // __AUDIO_ONSET_DETECTOR_H__
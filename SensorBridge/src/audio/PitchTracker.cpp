@@ -0,0 +1,123 @@
+#include <math.h>
+#include <stdlib.h>
+#include "PitchTracker.h"
+
+namespace audio {
+
+    // -46 dBFS (the release level) to full scale
+    static uint8_t velocityOf(float level) {
+        float db = 20.0f * log10f(level > 1e-6f ? level : 1e-6f);
+        int velocity = (int) ((db + 46.0f) * (126.0f / 46.0f) + 1.5f);
+        if (velocity < 1) velocity = 1;
+        if (velocity > 127) velocity = 127;
+        return (uint8_t) velocity;
+    }
+
+    PitchTracker::PitchTracker() {
+        begin(16000.0f);
+    }
+
+    void PitchTracker::begin(float sampleRate) {
+        this->sampleRate = sampleRate;
+        reset();
+    }
+
+    void PitchTracker::reset() {
+        yin_stream_init(&yin, sampleRate);
+        pitch = -1.0f;
+        probability = 0.0f;
+        level = 0.0f;
+        onsetWait = 0;
+        onsetTime = 0;
+        onsetVelocity = 0;
+        note = -1;
+        quietHops = 0;
+        unvoicedHops = 0;
+        outOfRangeHops = 0;
+        lastBend = -1;
+    }
+
+    int PitchTracker::process(const int16_t* hop, int64_t timestamp, const OnsetEvent* onset, PitchEvent* events) {
+        int count = 0;
+        float sum = 0.0f;
+        for (int i = 0; i < HopSize; i++) {
+            sum += (float) hop[i] * hop[i];
+        }
+        level = sqrtf(sum / HopSize) * (1.0f / 32768.0f);
+        pitch = yin_stream_push_hop(&yin, hop);
+        probability = yin_stream_last_pitch_estimate_probability(&yin);
+        bool voiced = pitch > 0.0f && probability >= MinProbability && level >= ReleaseLevel;
+        float midiPitch = voiced ? 69.0f + 12.0f * log2f(pitch / 440.0f) : 0.0f;
+
+        if (onset != nullptr) {
+            onsetWait = MaxOnsetWait;
+            onsetTime = onset->timestamp;
+            onsetVelocity = 0;
+        }
+
+        // the pending onset takes the first reliable pitch, the loudest hop
+        // until then gives the velocity
+        if (onsetWait > 0) {
+            uint8_t velocity = velocityOf(level);
+            if (velocity > onsetVelocity) onsetVelocity = velocity;
+            if (voiced) {
+                onsetWait = 0;
+                if (note >= 0) noteOff(onsetTime, events, count);
+                noteOn((int) lroundf(midiPitch), midiPitch, onsetTime, events, count);
+                return count;
+            }
+            onsetWait--;
+        }
+        if (note < 0) return count;
+
+        quietHops = level < ReleaseLevel ? quietHops + 1 : 0;
+        unvoicedHops = voiced ? 0 : unvoicedHops + 1;
+        if (quietHops >= ReleaseHops || unvoicedHops >= LostHops) {
+            noteOff(timestamp, events, count);
+            return count;
+        }
+        if (!voiced) return count;
+
+        // a glide past the bend range moves the note, a single wrong
+        // estimate (an octave error) does not
+        if (fabsf(midiPitch - note) > BendRange - 0.5f) {
+            if (++outOfRangeHops >= 2) {
+                noteOff(timestamp, events, count);
+                noteOn((int) lroundf(midiPitch), midiPitch, timestamp, events, count);
+            }
+            return count;
+        }
+        outOfRangeHops = 0;
+        bend(midiPitch, timestamp, events, count);
+        return count;
+    }
+
+    void PitchTracker::noteOn(int newNote, float midiPitch, int64_t timestamp, PitchEvent* events, int& count) {
+        if (newNote < 0) newNote = 0;
+        if (newNote > 127) newNote = 127;
+        note = newNote;
+        quietHops = 0;
+        unvoicedHops = 0;
+        outOfRangeHops = 0;
+        // the bend goes first so that the note starts in tune
+        lastBend = -1;
+        bend(midiPitch, timestamp, events, count);
+        events[count++] = { timestamp, 0x90, (uint8_t) note, onsetVelocity > 0 ? onsetVelocity : (uint8_t) 1 };
+    }
+
+    void PitchTracker::noteOff(int64_t timestamp, PitchEvent* events, int& count) {
+        events[count++] = { timestamp, 0x80, (uint8_t) note, 0 };
+        note = -1;
+    }
+
+    bool PitchTracker::bend(float midiPitch, int64_t timestamp, PitchEvent* events, int& count) {
+        int value = 8192 + (int) lroundf((midiPitch - note) * (8192.0f / BendRange));
+        if (value < 0) value = 0;
+        if (value > 16383) value = 16383;
+        if (lastBend >= 0 && abs(value - lastBend) < BendStep) return false;
+        lastBend = value;
+        events[count++] = { timestamp, 0xE0, (uint8_t) (value & 0x7F), (uint8_t) (value >> 7) };
+        return true;
+    }
+
+} // audio
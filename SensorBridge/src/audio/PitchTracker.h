@@ -0,0 +1,83 @@
+#ifndef __AUDIO_PITCH_TRACKER_H__
+#define __AUDIO_PITCH_TRACKER_H__
+
+#include <stdint.h>
+#include "../yin/yin_stream.h"
+#include "OnsetDetector.h"
+
+namespace audio {
+
+// A MIDI message found in the audio, sent on the mapper's channel
+struct PitchEvent {
+    int64_t timestamp;  // us, capture time of the hop it belongs to
+    uint8_t status;     // 0x90 note on, 0x80 note off or 0xE0 pitch bend
+    uint8_t data1;
+    uint8_t data2;
+};
+
+// Turns microphone audio into notes: streaming YIN gives a pitch for every
+// hop, an onset (from OnsetDetector, on the same hops) starts a note at the
+// nearest semitone, and pitch bend follows the pitch while it sounds.
+// A pitch that leaves the bend range for two hops moves the note, silence
+// or a lost pitch ends it.
+//
+// Latency: an estimate is ready when its hop is captured. A note on waits
+// at most MaxOnsetWait hops for a reliable pitch and is stamped with the
+// onset, so the receiver plays it at a constant delay as long as that
+// delay covers one DMA buffer plus MaxOnsetWait hops (40 ms at 8 ms hops).
+// No hardware or Arduino dependencies, bench/pitch_bench.cpp runs it on
+// WAV files. The YIN state is sized at compile time (yin/yin_stream.h) and
+// part of the object, nothing is allocated.
+class PitchTracker {
+public:
+    static const int HopSize = YIN_STREAM_HOP_SIZE;
+    static const int MaxEvents = 3;     // per hop: note off, pitch bend, note on
+    static const int BendRange = 2;     // semitones, the synth's default
+
+    PitchTracker();
+
+    void begin(float sampleRate);
+    void reset();
+
+    // One hop of HopSize samples, captured at timestamp, with the onset
+    // found in it or nullptr. Fills events (room for MaxEvents) and returns
+    // their number.
+    int process(const int16_t* hop, int64_t timestamp, const OnsetEvent* onset, PitchEvent* events);
+
+    // estimate of the last hop, -1 Hz when unvoiced
+    float getPitch() const { return pitch; }
+    float getProbability() const { return probability; }
+    float getLevel() const { return level; }      // RMS, 1 full scale
+    int getNote() const { return note; }          // sounding note, -1 none
+
+private:
+    static constexpr float MinProbability = 0.8f;
+    static constexpr float ReleaseLevel = 0.005f; // -46 dBFS, a note ends below this
+    static const int MaxOnsetWait = 4;            // hops an onset waits for a pitch
+    static const int ReleaseHops = 3;             // quiet hops that end a note
+    static const int LostHops = 8;                // unvoiced hops that end a note
+    static const int BendStep = 40;               // about a cent, smaller changes are not sent
+
+    void noteOn(int newNote, float midiPitch, int64_t timestamp, PitchEvent* events, int& count);
+    void noteOff(int64_t timestamp, PitchEvent* events, int& count);
+    bool bend(float midiPitch, int64_t timestamp, PitchEvent* events, int& count);
+
+    Yin_Stream yin;
+    float sampleRate;
+
+    float pitch;
+    float probability;
+    float level;
+    int onsetWait;          // hops left for the pending onset, 0 none
+    int64_t onsetTime;
+    uint8_t onsetVelocity;
+    int note;
+    int quietHops;
+    int unvoicedHops;
+    int outOfRangeHops;
+    int lastBend;
+};
+
+} // audio
+
+#endif // __AUDIO_PITCH_TRACKER_H__
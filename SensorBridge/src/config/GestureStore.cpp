@@ -0,0 +1,48 @@
+#include "GestureStore.h"
+#include <Preferences.h>
+
+const char* GestureStore::NAMESPACE = "gestures";
+
+static Preferences preferences;
+
+GestureStore::GestureStore() {
+}
+
+void GestureStore::begin() {
+    preferences.begin(NAMESPACE, false);
+}
+
+void GestureStore::key(int slot, char* buffer) {
+    snprintf(buffer, 8, "g%d", slot);
+}
+
+bool GestureStore::load(int slot, imu::GestureTemplate& gesture, GestureMidi& midi) {
+    char name[8];
+    key(slot, name);
+    Record record;
+    if (preferences.getBytesLength(name) != sizeof(Record)) {
+        return false;
+    }
+    preferences.getBytes(name, &record, sizeof(Record));
+    if (record.gesture.length == 0 || record.gesture.length > imu::GestureTemplate::MaxFrames) {
+        return false;
+    }
+    gesture = record.gesture;
+    midi = record.midi;
+    return true;
+}
+
+void GestureStore::save(int slot, const imu::GestureTemplate& gesture, const GestureMidi& midi) {
+    char name[8];
+    key(slot, name);
+    Record record;
+    record.gesture = gesture;
+    record.midi = midi;
+    preferences.putBytes(name, &record, sizeof(Record));
+}
+
+void GestureStore::remove(int slot) {
+    char name[8];
+    key(slot, name);
+    preferences.remove(name);
+}
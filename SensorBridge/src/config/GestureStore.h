@@ -0,0 +1,30 @@
+#ifndef GESTURE_STORE_H
+#define GESTURE_STORE_H
+
+#include <Arduino.h>
+#include "../imu/GestureRecognizer.h"
+#include "../MidiMapper.h"
+
+// Gesture templates and their MIDI messages in NVS, one record per slot
+class GestureStore {
+public:
+    GestureStore();
+    void begin();
+
+    // false when the slot is empty or holds a record of another layout
+    bool load(int slot, imu::GestureTemplate& gesture, GestureMidi& midi);
+    void save(int slot, const imu::GestureTemplate& gesture, const GestureMidi& midi);
+    void remove(int slot);
+
+private:
+    static const char* NAMESPACE;
+
+    struct Record {
+        imu::GestureTemplate gesture;
+        GestureMidi midi;
+    };
+
+    static void key(int slot, char* buffer);
+};
+
+#endif
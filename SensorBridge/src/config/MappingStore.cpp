@@ -0,0 +1,75 @@
+#include "MappingStore.h"
+#include <Preferences.h>
+
+const char* MappingStore::NAMESPACE = "mappings";
+const char* MappingStore::MAPPINGS_KEY = "maps";
+
+static Preferences preferences;
+
+// A mapping as stored before it had One Euro smoothing
+struct MappingV1 {
+    uint8_t source;
+    uint8_t curve;
+    uint8_t invert;
+    uint8_t target;
+    uint8_t channel;
+    uint8_t number;
+    uint8_t span;
+    float min;
+    float max;
+};
+
+MappingStore::MappingStore() {
+}
+
+void MappingStore::begin() {
+    preferences.begin(NAMESPACE, false);
+}
+
+bool MappingStore::load(MidiMapper& mapper) {
+    Mapping mappings[MidiMapper::MaxMappings];
+    size_t length = preferences.getBytesLength(MAPPINGS_KEY);
+    if (length == 0) {
+        return false;
+    }
+    if (length == sizeof(mappings)) {
+        preferences.getBytes(MAPPINGS_KEY, mappings, sizeof(mappings));
+    } else if (length == sizeof(MappingV1) * MidiMapper::MaxMappings) {
+        // the older format, its mappings are not smoothed like any set with /map/set
+        MappingV1 old[MidiMapper::MaxMappings];
+        preferences.getBytes(MAPPINGS_KEY, old, sizeof(old));
+        for (int i = 0; i < MidiMapper::MaxMappings; i++) {
+            Mapping mapping = { };
+            mapping.source = old[i].source;
+            mapping.curve = old[i].curve;
+            mapping.invert = old[i].invert;
+            mapping.target = old[i].target;
+            mapping.channel = old[i].channel;
+            mapping.number = old[i].number;
+            mapping.span = old[i].span;
+            mapping.min = old[i].min;
+            mapping.max = old[i].max;
+            mappings[i] = mapping;
+        }
+        Serial.println("Stored mappings converted, smoothing off");
+    } else {
+        Serial.println("Stored mappings discarded (unknown format)");
+        return false;
+    }
+    for (int i = 0; i < MidiMapper::MaxMappings; i++) {
+        mapper.setMapping(i, mappings[i]);
+    }
+    return true;
+}
+
+void MappingStore::save(const MidiMapper& mapper) {
+    Mapping mappings[MidiMapper::MaxMappings];
+    for (int i = 0; i < MidiMapper::MaxMappings; i++) {
+        mappings[i] = mapper.getMapping(i);
+    }
+    preferences.putBytes(MAPPINGS_KEY, mappings, sizeof(mappings));
+}
+
+void MappingStore::clear() {
+    preferences.remove(MAPPINGS_KEY);
+}
@@ -0,0 +1,23 @@
+#ifndef MAPPING_STORE_H
+#define MAPPING_STORE_H
+
+#include <Arduino.h>
+#include "../MidiMapper.h"
+
+// The mapper's source to MIDI mappings in NVS, all slots in one record
+class MappingStore {
+public:
+    MappingStore();
+    void begin();
+
+    // false when nothing is stored, the mapper then keeps its defaults
+    bool load(MidiMapper& mapper);
+    void save(const MidiMapper& mapper);
+    void clear();
+
+private:
+    static const char* NAMESPACE;
+    static const char* MAPPINGS_KEY;
+};
+
+#endif
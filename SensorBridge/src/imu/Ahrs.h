@@ -0,0 +1,93 @@
+#ifndef __IMU_AHRS_H__
+#define __IMU_AHRS_H__
+
+#include <stdint.h>
+#include "CycleCounter.h"
+#include "FastMath.h"
+
+#ifdef imu
+#undef imu
+#endif
+
+namespace imu {
+
+enum AhrsType {
+    AHRS_MAHONY = 0,
+    AHRS_MADGWICK,
+    AHRS_COMPLEMENTARY,
+    AHRS_TYPE_COUNT
+};
+
+// Orientation filter fusing gyroscope and accelerometer into a quaternion.
+// The orientation lives with the caller, so a filter can be swapped for
+// another one while running without a jump in the output.
+class Ahrs {
+public:
+    struct CycleStats {
+        uint32_t count;     // updates measured
+        uint32_t mean;      // cycles per update
+        uint32_t max;
+    };
+
+    virtual ~Ahrs() { }
+
+    virtual const char* name() const = 0;
+
+    // Nominal sample rate, used when a sample has no usable time step
+    virtual void setSampleRate(float sampleFreq) = 0;
+    virtual float getSampleRate() const = 0;
+
+    // Feedback gains. kp sets how fast the accelerometer pulls the
+    // estimate back, ki (where supported) how fast gyro bias is learned.
+    virtual void setGains(float kp, float ki) = 0;
+    virtual float getKp() const = 0;
+    virtual float getKi() const { return 0.0f; }
+
+    // Clear internal filter state
+    virtual void reset() = 0;
+
+    // gx, gy, gz in rad/s, accelerometer in any unit,
+    // dt is the measured time since the previous sample in seconds
+    inline void update(
+        float gx, float gy, float gz,
+        float ax, float ay, float az,
+        float dt,
+        float& q0, float& q1, float& q2, float& q3) {
+        uint32_t start = cycleCount();
+        UpdateQuaternion(gx, gy, gz, ax, ay, az, dt, q0, q1, q2, q3);
+        uint32_t cycles = cycleCount() - start;
+        cycleSum += cycles;
+        updateCount++;
+        if (cycles > cycleMax) cycleMax = cycles;
+    }
+
+    virtual void UpdateQuaternion(
+        float gx, float gy, float gz,
+        float ax, float ay, float az,
+        float dt,
+        float& q0, float& q1, float& q2, float& q3) = 0;
+
+    // Cost of update() since the last resetCycleStats()
+    CycleStats getCycleStats() const {
+        CycleStats stats;
+        stats.count = updateCount;
+        stats.mean = updateCount ? (uint32_t) (cycleSum / updateCount) : 0;
+        stats.max = cycleMax;
+        return stats;
+    }
+
+    void resetCycleStats() {
+        cycleSum = 0;
+        updateCount = 0;
+        cycleMax = 0;
+    }
+
+private:
+    uint64_t cycleSum = 0;
+    uint32_t updateCount = 0;
+    uint32_t cycleMax = 0;
+};
+
+} // imu
+
+#endif // __IMU_AHRS_H__
@@ -0,0 +1,80 @@
+#include <math.h>
+#include "AhrsBenchmark.h"
+
+namespace imu {
+
+    AhrsBenchmark::AhrsBenchmark() {
+        // slow swaying with some shakes on top, accelerometer in g and
+        // gyroscope in rad/s, plus a little deterministic noise
+        uint32_t seed = 12345;
+        const float dt = 0.005f;
+        for (int i = 0; i < TraceLength; i++) {
+            float t = i * dt;
+            float roll = 0.6f * sinf(2.0f * 3.14159265f * 0.5f * t);
+            float pitch = 0.4f * sinf(2.0f * 3.14159265f * 0.3f * t + 1.0f);
+            float shake = (i % 200 < 20) ? 1.5f * sinf(2.0f * 3.14159265f * 8.0f * t) : 0.0f;
+
+            acc[i][0] = -sinf(pitch);
+            acc[i][1] = sinf(roll) * cosf(pitch) + shake;
+            acc[i][2] = cosf(roll) * cosf(pitch);
+            gyro[i][0] = 0.6f * 2.0f * 3.14159265f * 0.5f * cosf(2.0f * 3.14159265f * 0.5f * t);
+            gyro[i][1] = 0.4f * 2.0f * 3.14159265f * 0.3f * cosf(2.0f * 3.14159265f * 0.3f * t + 1.0f);
+            gyro[i][2] = 0.1f;
+
+            for (int j = 0; j < 3; j++) {
+                seed = seed * 1664525u + 1013904223u;
+                acc[i][j] += ((int32_t) (seed >> 16) - 32768) * (0.01f / 32768.0f);
+                seed = seed * 1664525u + 1013904223u;
+                gyro[i][j] += ((int32_t) (seed >> 16) - 32768) * (0.02f / 32768.0f);
+            }
+        }
+    }
+
+    AhrsBenchmark::Result AhrsBenchmark::run(Ahrs& ahrs, int passes) {
+        Result result;
+        result.name = ahrs.name();
+        result.updates = 0;
+        result.meanCycles = 0.0f;
+        result.maxCycles = 0;
+
+        uint32_t best = UINT32_MAX;
+        float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f;
+        ahrs.reset();
+
+        for (int pass = 0; pass < passes; pass++) {
+            q0 = 1.0f; q1 = 0.0f; q2 = 0.0f; q3 = 0.0f;
+            ahrs.resetCycleStats();
+            uint32_t start = cycleCount();
+            for (int i = 0; i < TraceLength; i++) {
+                ahrs.UpdateQuaternion(
+                    gyro[i][0], gyro[i][1], gyro[i][2],
+                    acc[i][0], acc[i][1], acc[i][2],
+                    0.005f,
+                    q0, q1, q2, q3);
+            }
+            uint32_t cycles = cycleCount() - start;
+            if (cycles < best) best = cycles;
+
+            // second run through update() for the worst case of single calls,
+            // its own counter reads are included there
+            for (int i = 0; i < TraceLength; i++) {
+                ahrs.update(
+                    gyro[i][0], gyro[i][1], gyro[i][2],
+                    acc[i][0], acc[i][1], acc[i][2],
+                    0.005f,
+                    q0, q1, q2, q3);
+            }
+            Ahrs::CycleStats stats = ahrs.getCycleStats();
+            if (stats.max > result.maxCycles) result.maxCycles = stats.max;
+            result.updates += TraceLength;
+        }
+
+        result.meanCycles = (float) best / TraceLength;
+        result.quat[0] = q0;
+        result.quat[1] = q1;
+        result.quat[2] = q2;
+        result.quat[3] = q3;
+        return result;
+    }
+
+} // imu
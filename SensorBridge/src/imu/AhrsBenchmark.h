@@ -0,0 +1,35 @@
+#ifndef __IMU_AHRS_BENCHMARK_H__
+#define __IMU_AHRS_BENCHMARK_H__
+
+#include <stdint.h>
+#include "Ahrs.h"
+
+namespace imu {
+
+// Cost of one AHRS update on a synthetic motion trace. The same code runs on
+// the device (AHRS_BENCHMARK build flag) and on a PC (see bench/README.md).
+class AhrsBenchmark {
+public:
+    struct Result {
+        const char* name;
+        uint32_t updates;
+        float meanCycles;   // per update, over the fastest pass
+        uint32_t maxCycles; // slowest single update
+        float quat[4];      // final orientation, to compare backends
+    };
+
+    AhrsBenchmark();
+
+    // passes over the trace, the fastest pass is reported
+    Result run(Ahrs& ahrs, int passes = 8);
+
+    static const int TraceLength = 1000;    // 5 s at 200 Hz
+
+private:
+    float acc[TraceLength][3];
+    float gyro[TraceLength][3];
+};
+
+} // imu
+
+#endif // __IMU_AHRS_BENCHMARK_H__
@@ -0,0 +1,32 @@
+#ifndef __IMU_CYCLE_COUNTER_H__
+#define __IMU_CYCLE_COUNTER_H__
+
+#include <stdint.h>
+
+#if defined(ESP_PLATFORM)
+#include <xtensa/hal.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace imu {
+
+// Free running CPU cycle counter, for measuring short pieces of code.
+// On the ESP32 this is the Xtensa CCOUNT register (240 MHz), on a PC the
+// time stamp counter. Elsewhere it falls back to nanoseconds.
+static inline uint32_t cycleCount() {
+#if defined(ESP_PLATFORM)
+    return xthal_get_ccount();
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint32_t) __rdtsc();
+#else
+    return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+} // imu
+
+#endif // __IMU_CYCLE_COUNTER_H__
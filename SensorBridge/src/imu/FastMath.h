@@ -0,0 +1,31 @@
+#ifndef __IMU_FAST_MATH_H__
+#define __IMU_FAST_MATH_H__
+
+#include <stdint.h>
+#include <string.h>
+
+namespace imu {
+
+// float versions of Arduino's DEG_TO_RAD and RAD_TO_DEG, those are doubles
+// and turn every multiplication into a software double operation on the ESP32
+static const float DegToRad = 0.0174532925f;
+static const float RadToDeg = 57.2957795f;
+
+// Fast inverse square-root, one Newton step, relative error below 0.2%
+// See: http://en.wikipedia.org/wiki/Fast_inverse_square_root
+// The bits are moved with memcpy, which is well defined and compiles to a
+// register move, unlike the pointer cast of the original.
+static inline float invSqrt(float x) {
+    float halfx = 0.5f * x;
+    float y;
+    int32_t i;
+    memcpy(&i, &x, sizeof(i));
+    i = 0x5f3759df - (i >> 1);
+    memcpy(&y, &i, sizeof(y));
+    y = y * (1.5f - (halfx * y * y));
+    return y;
+}
+
+} // imu
+
+#endif // __IMU_FAST_MATH_H__
@@ -0,0 +1,237 @@
+#include <string.h>
+#include <stdlib.h>
+#include "GestureRecognizer.h"
+
+namespace imu {
+
+    static int8_t quantize(float value, float scale) {
+        int q = (int) (value * scale + (value >= 0.0f ? 0.5f : -0.5f));
+        if (q > 127) q = 127;
+        if (q < -127) q = -127;
+        return (int8_t) q;
+    }
+
+    GestureRecognizer::GestureRecognizer() : comparisons(0), abandons(0) {
+        memset(templates, 0, sizeof(templates));
+        recordSlot = -1;
+        reset();
+    }
+
+    void GestureRecognizer::reset() {
+        frameStart = 0;
+        frameSamples = 0;
+        memset(sum, 0, sizeof(sum));
+        memset(gravity, 0, sizeof(gravity));
+        hasGravity = false;
+        memset(ring, 0, sizeof(ring));
+        frameCount = 0;
+        lastActiveFrame = 0;
+        quietUntilFrame = 0;
+        nextTemplate = MaxTemplates;
+        bestSlot = -1;
+        recordStarted = false;
+    }
+
+    void GestureRecognizer::setTemplate(int slot, const GestureTemplate& gesture) {
+        if (slot < 0 || slot >= MaxTemplates) return;
+        templates[slot] = gesture;
+        if (templates[slot].length > GestureTemplate::MaxFrames) {
+            templates[slot].length = 0;
+        }
+    }
+
+    void GestureRecognizer::clearTemplate(int slot) {
+        if (slot < 0 || slot >= MaxTemplates) return;
+        templates[slot].length = 0;
+    }
+
+    void GestureRecognizer::setThreshold(int slot, uint16_t threshold) {
+        if (slot < 0 || slot >= MaxTemplates) return;
+        templates[slot].threshold = threshold;
+    }
+
+    void GestureRecognizer::record(int slot) {
+        if (slot < 0 || slot >= MaxTemplates) return;
+        recordSlot = slot;
+        recordStarted = false;
+    }
+
+    bool GestureRecognizer::push(const ImuSample& sample, GestureEvent& event) {
+        bool hasEvent = false;
+
+        if (frameSamples == 0) {
+            frameStart = sample.timestamp;
+        }
+        for (int i = 0; i < 3; i++) {
+            sum[i] += sample.acc[i];
+            sum[3 + i] += sample.gyro[i];
+        }
+        frameSamples++;
+
+        if (sample.timestamp - frameStart >= FramePeriod - FramePeriod / 8) {
+            closeFrame(sample.timestamp, event, hasEvent);
+            if (hasEvent) return true;
+        }
+
+        // one template per sample until the newest frames were compared with all
+        if (nextTemplate < MaxTemplates) {
+            const GestureTemplate& gesture = templates[nextTemplate];
+            uint32_t limit = gesture.threshold;
+            if (bestDistance < limit) limit = bestDistance;
+            uint32_t distance = compare(gesture, limit);
+            if (distance <= limit) {
+                bestDistance = distance;
+                bestSlot = nextTemplate;
+            }
+            nextTemplate = nextSlot(nextTemplate + 1);
+
+            if (nextTemplate >= MaxTemplates && bestSlot >= 0) {
+                event.timestamp = matchTime;
+                event.gesture = (uint8_t) bestSlot;
+                event.distance = (uint16_t) bestDistance;
+                event.recorded = false;
+                // the same motion is not reported again, the next one takes as long
+                quietUntilFrame = frameCount + templates[bestSlot].length;
+                bestSlot = -1;
+                return true;
+            }
+        }
+        return hasEvent;
+    }
+
+    int GestureRecognizer::nextSlot(int slot) const {
+        while (slot < MaxTemplates && templates[slot].length == 0) {
+            slot++;
+        }
+        return slot;
+    }
+
+    void GestureRecognizer::closeFrame(int64_t timestamp, GestureEvent& event, bool& hasEvent) {
+        float mean[GestureChannels];
+        for (int i = 0; i < GestureChannels; i++) {
+            mean[i] = sum[i] / frameSamples;
+            sum[i] = 0.0f;
+        }
+        frameSamples = 0;
+        if (!hasGravity) {
+            memcpy(gravity, mean, sizeof(gravity));
+            hasGravity = true;
+        }
+
+        int8_t* frame = ring[frameCount & (RingFrames - 1)];
+        int activity = 0;
+        for (int i = 0; i < 3; i++) {
+            frame[i] = quantize(mean[i] - gravity[i], 32.0f);       // 1/32 g
+            frame[3 + i] = quantize(mean[3 + i], 1.0f / 8.0f);      // 8 deg/s
+            activity += abs(frame[i]) + abs(frame[3 + i]);
+        }
+        bool active = activity >= ActivityThreshold;
+        if (active) {
+            lastActiveFrame = frameCount;
+        } else {
+            // gravity only follows the quiet frames, about 1 s time constant
+            for (int i = 0; i < 3; i++) {
+                gravity[i] += 0.04f * (mean[i] - gravity[i]);
+            }
+        }
+        frameCount++;
+        nextTemplate = MaxTemplates;
+
+        if (recordSlot >= 0) {
+            if (!recordStarted) {
+                if (active) {
+                    recordStarted = true;
+                    recordStart = frameCount - 1;
+                }
+            } else {
+                int length = (int) (lastActiveFrame + 2 - recordStart);   // one quiet frame of tail
+                if (frameCount - 1 - lastActiveFrame >= QuietFrames || length >= GestureTemplate::MaxFrames) {
+                    if (length > GestureTemplate::MaxFrames) length = GestureTemplate::MaxFrames;
+                    if (length >= MinFrames) {
+                        finishRecording(length, timestamp, event);
+                        hasEvent = true;
+                    } else {
+                        recordStarted = false;  // too short, wait for the next motion
+                    }
+                }
+            }
+            return;
+        }
+
+        // compare while a gesture can have ended in the newest frames
+        if (frameCount >= quietUntilFrame && frameCount - 1 - lastActiveFrame <= Band) {
+            nextTemplate = nextSlot(0);
+            bestSlot = -1;
+            bestDistance = Infinity;
+            matchTime = timestamp;
+        }
+    }
+
+    void GestureRecognizer::finishRecording(int length, int64_t timestamp, GestureEvent& event) {
+        GestureTemplate& gesture = templates[recordSlot];
+        uint32_t activity = 0;
+        for (int i = 0; i < length; i++) {
+            const int8_t* frame = frameAt(recordStart + i);
+            memcpy(gesture.frames[i], frame, GestureChannels);
+            for (int c = 0; c < GestureChannels; c++) {
+                activity += abs(frame[c]);
+            }
+        }
+        gesture.length = (uint8_t) length;
+        // stronger gestures vary more between repetitions
+        uint32_t threshold = activity / length * ThresholdPercent / 100;
+        gesture.threshold = (uint16_t) (threshold < MinThreshold ? MinThreshold : threshold);
+
+        event.timestamp = timestamp;
+        event.gesture = (uint8_t) recordSlot;
+        event.distance = 0;
+        event.recorded = true;
+        recordSlot = -1;
+        recordStarted = false;
+        quietUntilFrame = frameCount + length;
+    }
+
+    uint32_t GestureRecognizer::compare(const GestureTemplate& gesture, uint32_t limit) {
+        const int n = gesture.length;
+        if (frameCount < (uint32_t) n) return Infinity;
+        comparisons++;
+        const uint32_t first = frameCount - n;  // oldest frame of the window
+        const uint32_t rowLimit = limit * n;
+
+        // row[prev][j + 1] is the cost of template row i - 1 ending at window frame j
+        uint32_t* prev = row[0];
+        uint32_t* cur = row[1];
+        for (int j = 0; j <= n; j++) prev[j] = Infinity;
+        prev[0] = 0;
+        for (int j = 0; j <= n; j++) cur[j] = Infinity;
+
+        for (int i = 0; i < n; i++) {
+            const int8_t* t = gesture.frames[i];
+            int jlo = i - Band < 0 ? 0 : i - Band;
+            int jhi = i + Band >= n ? n - 1 : i + Band;
+            cur[jlo] = Infinity;
+            uint32_t rowMin = Infinity;
+            for (int j = jlo; j <= jhi; j++) {
+                const int8_t* w = frameAt(first + j);
+                uint32_t cost = abs(t[0] - w[0]) + abs(t[1] - w[1]) + abs(t[2] - w[2])
+                              + abs(t[3] - w[3]) + abs(t[4] - w[4]) + abs(t[5] - w[5]);
+                uint32_t best = prev[j];            // diagonal
+                if (prev[j + 1] < best) best = prev[j + 1];
+                if (cur[j] < best) best = cur[j];
+                uint32_t total = best + cost;
+                cur[j + 1] = total;
+                if (total < rowMin) rowMin = total;
+            }
+            // costs only grow along the path, no cell of this row can still match
+            if (rowMin > rowLimit) {
+                abandons++;
+                return Infinity;
+            }
+            uint32_t* swap = prev;
+            prev = cur;
+            cur = swap;
+        }
+        return prev[n] / n;
+    }
+
+} // imu
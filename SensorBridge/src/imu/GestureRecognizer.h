@@ -0,0 +1,121 @@
+#ifndef __IMU_GESTURE_RECOGNIZER_H__
+#define __IMU_GESTURE_RECOGNIZER_H__
+
+#include <stdint.h>
+#include "ImuData.h"
+
+namespace imu {
+
+// feature channels per frame: acceleration without gravity, then gyro
+static const int GestureChannels = 6;
+
+// A recorded gesture: feature frames from its onset until the motion stops.
+// Plain data, stored as is in NVS.
+struct GestureTemplate {
+    static const int MaxFrames = 32;        // 1.28 s at 25 frames per second
+
+    uint8_t length;                         // frames, 0 for an empty slot
+    uint16_t threshold;                     // largest distance per frame that still matches
+    int8_t frames[MaxFrames][GestureChannels];
+};
+
+struct GestureEvent {
+    int64_t timestamp;  // sample time of the frame that completed the gesture
+    uint8_t gesture;    // template slot
+    uint16_t distance;  // DTW distance per frame, lower is closer
+    bool recorded;      // the slot's template was recorded, not matched
+};
+
+// Copy of a freshly recorded template, handed to the task that stores it
+struct RecordedGesture {
+    uint8_t slot;
+    GestureTemplate gesture;
+};
+
+// Matches the motion of the last second or so against recorded gestures.
+// Samples are averaged into frames of 40 ms and quantized to 8 bits per
+// channel (1/32 g, 8 deg/s), frames go into a fixed ring. When there was
+// motion in the last frames, the newest frames are compared with every
+// template by DTW in a Sakoe-Chiba band, in integers; a comparison stops
+// as soon as a whole row exceeds the best distance so far. The work is
+// spread over the samples: one template per sample, so the cost of a
+// sample stays bounded whatever the number of templates.
+class GestureRecognizer {
+public:
+    static const int MaxTemplates = 8;
+
+    GestureRecognizer();
+
+    void setTemplate(int slot, const GestureTemplate& gesture);
+    const GestureTemplate& getTemplate(int slot) const { return templates[slot]; }
+    void clearTemplate(int slot);
+    void setThreshold(int slot, uint16_t threshold);
+
+    // Record the next gesture into slot: it starts with motion and ends when
+    // the device is quiet again. Completion is reported as an event.
+    void record(int slot);
+    bool isRecording() const { return recordSlot >= 0; }
+
+    // Forget the window, the templates are kept
+    void reset();
+
+    // One raw sample (gyro offset already removed). Returns true and fills
+    // event when a gesture was matched or recorded.
+    bool push(const ImuSample& sample, GestureEvent& event);
+
+    uint32_t getComparisonCount() const { return comparisons; }
+    uint32_t getAbandonCount() const { return abandons; }
+
+private:
+    static const int64_t FramePeriod = 40000;       // us, 25 frames per second
+    static const int RingFrames = 64;               // template plus quiet tail, power of two
+    static const int Band = 4;                      // frames of time warp, 160 ms
+    static const int ActivityThreshold = 24;        // sum of |features| that is motion
+    static const int QuietFrames = 3;               // quiet frames that end a recording
+    static const int MinFrames = 5;                 // shorter motion is not a gesture
+    static const int ThresholdPercent = 50;         // of the template's mean activity
+    static const int MinThreshold = 8;
+    static const uint32_t Infinity = 0x7fffffff;
+
+    // first slot from slot on that holds a template, MaxTemplates if none
+    int nextSlot(int slot) const;
+    void closeFrame(int64_t timestamp, GestureEvent& event, bool& hasEvent);
+    void finishRecording(int length, int64_t timestamp, GestureEvent& event);
+    // distance per frame of the newest frames to a template, Infinity when
+    // it exceeds limit (per frame)
+    uint32_t compare(const GestureTemplate& gesture, uint32_t limit);
+    const int8_t* frameAt(uint32_t index) const { return ring[index & (RingFrames - 1)]; }
+
+    GestureTemplate templates[MaxTemplates];
+
+    // frame being averaged
+    int64_t frameStart;
+    int frameSamples;
+    float sum[GestureChannels];
+    float gravity[3];
+    bool hasGravity;
+
+    int8_t ring[RingFrames][GestureChannels];
+    uint32_t frameCount;
+    uint32_t lastActiveFrame;
+    uint32_t quietUntilFrame;   // no matches before this frame
+
+    // comparison of the newest frames, one template per sample
+    int nextTemplate;           // MaxTemplates when done
+    int64_t matchTime;
+    int bestSlot;
+    uint32_t bestDistance;
+    uint32_t row[2][GestureTemplate::MaxFrames + 1];
+
+    // recording
+    int recordSlot;
+    uint32_t recordStart;       // frame of the onset
+    bool recordStarted;         // motion seen, recording frames
+
+    uint32_t comparisons;
+    uint32_t abandons;
+};
+
+} // imu
+
+#endif // __IMU_GESTURE_RECOGNIZER_H__
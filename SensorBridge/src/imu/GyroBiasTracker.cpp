@@ -0,0 +1,81 @@
+#include <math.h>
+#include "GyroBiasTracker.h"
+
+namespace imu {
+
+    GyroBiasTracker::GyroBiasTracker() {
+        reset();
+    }
+
+    void GyroBiasTracker::reset() {
+        gyroStats.reset();
+        accStats.reset();
+        bias[0] = 0.0f;
+        bias[1] = 0.0f;
+        bias[2] = 0.0f;
+        variance = InitialVariance;
+        updates = 0;
+        lastUpdate = 0;
+    }
+
+    float GyroBiasTracker::getUncertainty() const {
+        return sqrtf(variance);
+    }
+
+    bool GyroBiasTracker::push(const ImuSample& sample) {
+        // the window ends before the first sample past its period
+        bool changed = false;
+        if (gyroStats.count() > 0 && sample.timestamp - windowStart >= WindowPeriod) {
+            changed = closeWindow();
+        }
+        if (gyroStats.count() == 0) {
+            windowStart = sample.timestamp;
+        }
+        windowEnd = sample.timestamp;
+        gyroStats.push(sample.gyro[0], sample.gyro[1], sample.gyro[2]);
+        accStats.push(sample.acc[0], sample.acc[1], sample.acc[2]);
+        return changed;
+    }
+
+    bool GyroBiasTracker::closeWindow() {
+        float accX = accStats.meanX();
+        float accY = accStats.meanY();
+        float accZ = accStats.meanZ();
+        float accNorm = sqrtf(accX * accX + accY * accY + accZ * accZ);
+        bool still = gyroStats.count() >= MinWindowSamples
+            && gyroStats.maxStddev() < StillGyroStddev
+            && accStats.maxStddev() < StillAccStddev
+            && fabsf(accNorm - 1.0f) < StillAccNorm;
+
+        bool changed = false;
+        if (still) {
+            // the estimate gets less certain as time passes
+            if (lastUpdate != 0) {
+                variance += DriftVariance * (windowStart - lastUpdate) * 1e-6f;
+                if (variance > InitialVariance) variance = InitialVariance;
+            }
+
+            float mean[ImuXyz] = { gyroStats.meanX(), gyroStats.meanY(), gyroStats.meanZ() };
+            float measurementVariance = gyroStats.maxStderrMean();
+            measurementVariance *= measurementVariance;
+
+            // a steady slow turn is quiet too, but far from the estimate
+            float limit = fmaxf(MaxInnovation * sqrtf(variance + measurementVariance), MinInnovationLimit);
+            if (fabsf(mean[0] - bias[0]) < limit && fabsf(mean[1] - bias[1]) < limit && fabsf(mean[2] - bias[2]) < limit) {
+                float gain = variance / (variance + measurementVariance);
+                for (int i = 0; i < ImuXyz; i++) {
+                    bias[i] += gain * (mean[i] - bias[i]);
+                }
+                variance *= (1.0f - gain);
+                lastUpdate = windowEnd;
+                updates++;
+                changed = true;
+            }
+        }
+
+        gyroStats.reset();
+        accStats.reset();
+        return changed;
+    }
+
+} // imu
@@ -0,0 +1,60 @@
+#ifndef __IMU_GYRO_BIAS_TRACKER_H__
+#define __IMU_GYRO_BIAS_TRACKER_H__
+
+#include <stdint.h>
+#include "ImuData.h"
+#include "RunningStats.h"
+
+namespace imu {
+
+// Estimates the gyro offset in the background. Samples are collected in
+// windows of 0.5 s, whatever the sample rate; a window in which gyro and
+// accelerometer are quiet and the accelerometer reads 1 g is a stillness
+// window, its mean gyro rate is a measurement of the offset. Measurements
+// are merged with a scalar Kalman filter per axis: the first one is taken
+// almost as is, later ones only refine the estimate as its uncertainty
+// grows with time (temperature drift).
+class GyroBiasTracker {
+public:
+    GyroBiasTracker();
+
+    // Forget the estimate, the next stillness window sets it again
+    void reset();
+
+    // Feed one raw sample (gyro without offset applied), returns true when
+    // the estimate changed
+    bool push(const ImuSample& sample);
+
+    const float* getBias() const { return bias; }
+    // standard deviation of the estimate in deg/s, large until the first update
+    float getUncertainty() const;
+    uint32_t getUpdateCount() const { return updates; }
+    bool hasEstimate() const { return updates > 0; }
+
+private:
+    static const int64_t WindowPeriod = 500000;        // us
+    static const int MinWindowSamples = 20;            // fewer is a gap, not a measurement
+    static constexpr float StillGyroStddev = 0.3f;     // deg/s
+    static constexpr float StillAccStddev = 0.01f;     // g
+    static constexpr float StillAccNorm = 0.05f;       // g away from 1 g
+    static constexpr float InitialVariance = 25.0f;    // (deg/s)^2, offset unknown
+    static constexpr float DriftVariance = 1e-4f;      // (deg/s)^2 per second
+    static constexpr float MaxInnovation = 3.0f;       // sigma, larger is motion
+    static constexpr float MinInnovationLimit = 0.2f;  // deg/s, allowed whatever sigma says
+
+    bool closeWindow();
+
+    RunningStatsXYZ gyroStats;
+    RunningStatsXYZ accStats;
+    int64_t windowStart = 0;
+    int64_t windowEnd = 0;      // last sample of the window
+    int64_t lastUpdate = 0;
+
+    float bias[ImuXyz];
+    float variance;     // same for all axes, they get the same updates
+    uint32_t updates;
+};
+
+} // imu
+
+#endif // __IMU_GYRO_BIAS_TRACKER_H__
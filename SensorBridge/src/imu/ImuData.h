@@ -2,28 +2,46 @@
 #define __IMU_IMU_DATA_H__
 
 #include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 
 namespace imu {
 
 static const int ImuXyz = 3;
 static const int ImuWxyz = 4;
 static const int ImuWpjw = 3;
-static const int ImuDataLen = 56;//4 + (4*3) + (4*3) + (4*4) + (4*3);
+
+// One raw accelerometer and gyro reading
+struct ImuSample {
+    int64_t timestamp; // esp_timer microseconds
+    float acc[ImuXyz];  // g
+    float gyro[ImuXyz]; // deg/s
+};
 
 struct ImuData {
 public:
-    uint32_t timestamp;
+    int64_t timestamp; // sample time, esp_timer microseconds
     float acc[ImuXyz];
     float gyro[ImuXyz];
     float quat[ImuWxyz];
     float orientation[ImuWpjw]; //pitch jaw roll
+    float tempo;            // BPM of the movement, 0 before it was found
+    float tempoPhase;       // 0 - 1 of the beat, 0 on the beat
+    float tempoConfidence;  // 0 - 1
+    float motionEnergy;     // g RMS of the acceleration without gravity, see MotionFeatures.h
+    float motionJerk;       // g/s RMS
+    float motionFrequency;  // Hz, 0 at rest
+    float motionBands[3];   // g RMS per band
 
     explicit ImuData() : timestamp(0) {
-        memset(this, 0, ImuDataLen);
+        memset(this, 0, sizeof(ImuData));
         quat[0] = 1.0F;
     }
 
+#ifdef ARDUINO
     String getPitchString() {
         char buf[20];  // enough for 0–255
         std::sprintf(buf, "%i", (int)orientation[0]);
@@ -39,6 +57,7 @@ public:
         std::sprintf(buf, "%i", (int)orientation[2]);
         return String(buf);
     }
+#endif
 };
 
 } // imu
@@ -0,0 +1,187 @@
+#include <string.h>
+#include <math.h>
+#include "ImuPipeline.h"
+
+namespace imu {
+    ImuPipeline::ImuPipeline() : ahrs(&mahony), imuData() {
+        memset(gyroOffsets, 0, sizeof(float) * ImuXyz);
+    }
+
+    void ImuPipeline::setSampleRate(float sampleRateHz) {
+        mahony.setSampleRate(sampleRateHz);
+        madgwick.setSampleRate(sampleRateHz);
+        complementary.setSampleRate(sampleRateHz);
+    }
+
+    bool ImuPipeline::setAhrs(AhrsType type) {
+        Ahrs* next;
+        switch (type) {
+            case AHRS_MAHONY: next = &mahony; break;
+            case AHRS_MADGWICK: next = &madgwick; break;
+            case AHRS_COMPLEMENTARY: next = &complementary; break;
+            default: return false;
+        }
+        if (next == ahrs) return true;
+        // the quaternion is kept in imuData, the new filter carries on from it
+        next->reset();
+        next->resetCycleStats();
+        ahrs = next;
+        ahrsType = type;
+        return true;
+    }
+
+    bool ImuPipeline::writeGyroOffset(float x, float y, float z) {
+        gyroOffsets[0] = x;
+        gyroOffsets[1] = y;
+        gyroOffsets[2] = z;
+        return true;
+    }
+
+    void ImuPipeline::enableGyroBiasTracking(bool enable) {
+        if (enable && !biasTracking) {
+            biasTracker.reset();
+        }
+        biasTracking = enable;
+    }
+
+    void ImuPipeline::setZero() {
+        memcpy(&imuDataRef, &imuData, sizeof(ImuData));
+        zeroRefSet = true;
+        lastEulerTime = 0;
+    }
+
+    void ImuPipeline::process(const ImuSample& sample) {
+        float& ax = imuData.acc[0];
+        float& ay = imuData.acc[1];
+        float& az = imuData.acc[2];
+        float& gx = imuData.gyro[0];
+        float& gy = imuData.gyro[1];
+        float& gz = imuData.gyro[2];
+        float& qw = imuData.quat[0];
+        float& qx = imuData.quat[1];
+        float& qy = imuData.quat[2];
+        float& qz = imuData.quat[3];
+
+        ax = sample.acc[0];
+        ay = sample.acc[1];
+        az = sample.acc[2];
+        gx = sample.gyro[0];
+        gy = sample.gyro[1];
+        gz = sample.gyro[2];
+
+        // taps are found at the full sample rate, a full queue drops them
+        TapEvent tap;
+        if (tapDetector.push(sample.timestamp, ax, ay, az, tap)) {
+            tapEvents.push(tap);
+        }
+
+        if (biasTracking && biasTracker.push(sample)) {
+            const float* bias = biasTracker.getBias();
+            writeGyroOffset(bias[0], bias[1], bias[2]);
+        }
+        
+        gx -= gyroOffsets[0];
+        gy -= gyroOffsets[1];
+        gz -= gyroOffsets[2];
+
+        ImuSample corrected = sample;
+        corrected.gyro[0] = gx;
+        corrected.gyro[1] = gy;
+        corrected.gyro[2] = gz;
+        // a recording waits here until the consumer has room for it
+        if (recordingPending && recordedGestures.push(pendingRecording)) {
+            recordingPending = false;
+        }
+        GestureEvent gesture;
+        if (gestureRecognizer.push(corrected, gesture)) {
+            if (gesture.recorded) {
+                pendingRecording.slot = gesture.gesture;
+                pendingRecording.gesture = gestureRecognizer.getTemplate(gesture.gesture);
+                recordingPending = !recordedGestures.push(pendingRecording);
+            }
+            gestureEvents.push(gesture);
+        }
+
+        tempoTracker.push(sample.timestamp, ax, ay, az);
+        imuData.tempo = tempoTracker.getTempo();
+        imuData.tempoPhase = tempoTracker.getPhase(sample.timestamp);
+        imuData.tempoConfidence = tempoTracker.getConfidence();
+
+        // integrate over the real time step, the first sample has none
+        float dt = (lastSampleTime != 0) ? (sample.timestamp - lastSampleTime) * 1e-6f : 0.0f;
+        lastSampleTime = sample.timestamp;
+
+        ahrs->update(
+            gx * DegToRad, gy * DegToRad, gz * DegToRad,
+            ax, ay, az,
+            dt,
+            qw, qx, qy, qz);
+
+        // descriptors need the direction of gravity, after the AHRS
+        motionFeatures.push(sample.timestamp, imuData.acc, imuData.quat);
+        imuData.motionEnergy = motionFeatures.getEnergy();
+        imuData.motionJerk = motionFeatures.getJerk();
+        imuData.motionFrequency = motionFeatures.getFrequency();
+        for (int i = 0; i < MotionFeatures::Bands; i++) {
+            imuData.motionBands[i] = motionFeatures.getBand(i);
+        }
+
+        // update euler at 50 hz, whatever the sample rate;
+
+        if (sample.timestamp - lastEulerTime >= 20000) {
+            lastEulerTime = sample.timestamp;
+            if (zeroRefSet) {
+                // Conjugate of reference
+                float cq0 = imuDataRef.quat[0];
+                float cq1 = -imuDataRef.quat[1];
+                float cq2 = -imuDataRef.quat[2];
+                float cq3 = -imuDataRef.quat[3];
+
+                // Relative quaternion = conj(q_ref) * q_raw
+                float qr0, qr1, qr2, qr3;
+                quatMultiply(cq0, cq1, cq2, cq3, imuData.quat[0], imuData.quat[1], imuData.quat[2], imuData.quat[3], qr0, qr1, qr2, qr3);
+
+                QuaternionToEuler(qr0, qr1, qr2, qr3,  imuData.orientation[2], imuData.orientation[0], imuData.orientation[1]);
+        
+            } else {
+
+                QuaternionToEuler(imuData.quat[0], imuData.quat[1], imuData.quat[2], imuData.quat[3],  imuData.orientation[2], imuData.orientation[0], imuData.orientation[1]);
+            }
+             imuData.orientation[1] *= -1;
+        }
+
+        imuData.timestamp = sample.timestamp;
+    }
+
+    void ImuPipeline::quatMultiply (
+        float q0a, float q1a, float q2a, float q3a,
+        float q0b, float q1b, float q2b, float q3b,
+        float &q0, float &q1, float &q2, float &q3)
+    {
+        q0 = q0a*q0b - q1a*q1b - q2a*q2b - q3a*q3b;
+        q1 = q0a*q1b + q1a*q0b + q2a*q3b - q3a*q2b;
+        q2 = q0a*q2b - q1a*q3b + q2a*q0b + q3a*q1b;
+        q3 = q0a*q3b + q1a*q2b - q2a*q1b + q3a*q0b;
+    }
+
+    void ImuPipeline::QuaternionToEuler(float& q0, float& q1, float& q2, float& q3,  float& pitch, float& roll, float& yaw) {
+        // roll (x-axis rotation)
+        float sinr_cosp = 2.0f * (q0 * q1 + q2 * q3);
+        float cosr_cosp = 1.0f - 2.0f * (q1 * q1 + q2 * q2);
+        roll = atan2f(sinr_cosp, cosr_cosp);
+
+        // pitch (y-axis rotation), atan2 instead of asin for a -180 - 180 range
+        pitch = atan2f(2.0f * (q0 * q2 + q1 * q3),
+                       1.0f - 2.0f * (q2 * q2 + q3 * q3));
+
+        // yaw (z-axis rotation)
+        float siny_cosp = 2.0f * (q0 * q3 + q1 * q2);
+        float cosy_cosp = 1.0f - 2.0f * (q2 * q2 + q3 * q3);
+        yaw = atan2f(siny_cosp, cosy_cosp);
+
+        pitch *= RadToDeg;
+        yaw   *= RadToDeg;
+        roll  *= RadToDeg;
+    }
+
+} // imu
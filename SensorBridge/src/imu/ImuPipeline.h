@@ -0,0 +1,102 @@
+#ifndef __IMU_IMU_PIPELINE_H__
+#define __IMU_IMU_PIPELINE_H__
+
+#include "Ahrs.h"
+#include "FastMath.h"
+#include "mahony/MahonyAHRS.h"
+#include "madgwick/MadgwickAHRS.h"
+#include "complementary/ComplementaryFilter.h"
+#include "ImuData.h"
+#include "GyroBiasTracker.h"
+#include "TapDetector.h"
+#include "GestureRecognizer.h"
+#include "TempoTracker.h"
+#include "MotionFeatures.h"
+#include "../util/SpscQueue.h"
+
+namespace imu {
+
+// Everything that turns raw samples into an ImuData frame: gyro offset,
+// AHRS, zero reference and Euler angles. No hardware access, the same code
+// runs on the device (inside ImuReader) and in the host replay tools.
+// Owned by one task, only the tap and gesture events are taken out by
+// another one.
+class ImuPipeline {
+public:
+    ImuPipeline();
+
+    // Nominal sample rate of the AHRS
+    void setSampleRate(float sampleRateHz);
+    float getSampleRate() const { return ahrs->getSampleRate(); }
+    // Orientation filter, the orientation carries on when switching
+    bool setAhrs(AhrsType type);
+    AhrsType getAhrsType() const { return ahrsType; }
+    Ahrs& getAhrs() { return *ahrs; }
+
+    bool writeGyroOffset(float x, float y, float z);
+    const float* getGyroOffset() const { return gyroOffsets; }
+    // Keep the gyro offset up to date from the moments the device lies still
+    void enableGyroBiasTracking(bool enable);
+    bool isGyroBiasTracking() const { return biasTracking; }
+    const GyroBiasTracker& getGyroBiasTracker() const { return biasTracker; }
+
+    // Use the current orientation as zero
+    void setZero();
+
+    TapDetector& getTapDetector() { return tapDetector; }
+    // Taps found so far, may be called from one other task
+    bool popTapEvent(TapEvent& event) { return tapEvents.pop(event); }
+
+    GestureRecognizer& getGestureRecognizer() { return gestureRecognizer; }
+    const GestureRecognizer& getGestureRecognizer() const { return gestureRecognizer; }
+    // Gestures matched or recorded so far, may be called from one other task
+    bool popGestureEvent(GestureEvent& event) { return gestureEvents.pop(event); }
+    // Templates recorded so far, copied when they were finished. A copy the
+    // queue has no room for is kept and posted on the next samples; only a
+    // further recording before that replaces it.
+    bool popRecordedGesture(RecordedGesture& recorded) { return recordedGestures.pop(recorded); }
+
+    TempoTracker& getTempoTracker() { return tempoTracker; }
+    MotionFeatures& getMotionFeatures() { return motionFeatures; }
+
+    void process(const ImuSample& sample);
+    const ImuData& getData() const { return imuData; }
+
+    void QuaternionToEuler(float& q0, float& q1, float& q2, float& q3,  float& pitch, float& roll, float& yaw);
+
+    void quatMultiply (
+        float q0a, float q1a, float q2a, float q3a,
+        float q0b, float q1b, float q2b, float q3b,
+        float &q0, float &q1, float &q2, float &q3);
+
+private:
+    mahony::MahonyAHRS mahony;
+    madgwick::MadgwickAHRS madgwick;
+    complementary::ComplementaryFilter complementary;
+    Ahrs* volatile ahrs;    // switched by other tasks
+    AhrsType ahrsType = AHRS_MAHONY;
+    ImuData imuData;
+    ImuData imuDataRef;
+
+    int64_t lastSampleTime = 0;
+    int64_t lastEulerTime = 0;
+    float gyroOffsets[ImuXyz];
+    GyroBiasTracker biasTracker;
+    bool biasTracking = false;
+
+    bool zeroRefSet = false;
+
+    TapDetector tapDetector;
+    SpscQueue<TapEvent, 16> tapEvents;
+    GestureRecognizer gestureRecognizer;
+    SpscQueue<GestureEvent, 8> gestureEvents;
+    SpscQueue<RecordedGesture, 2> recordedGestures;
+    RecordedGesture pendingRecording;
+    bool recordingPending = false;
+    TempoTracker tempoTracker;
+    MotionFeatures motionFeatures;
+};
+
+} // imu
+
+#endif // __IMU_IMU_PIPELINE_H__
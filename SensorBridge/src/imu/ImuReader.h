@@ -1,10 +1,15 @@
 #ifndef __IMU_IMU_READER_H__
 #define __IMU_IMU_READER_H__
 
+#include <atomic>
 #include <M5Unified.h>
 #include "utility/IMU_Class.hpp"
-#include "mahony/MahonyAHRS.h"
 #include "ImuData.h"
+#include "ImuPipeline.h"
+#include "Mpu6886Fifo.h"
+#include "TraceRecorder.h"
+#include "../util/SeqLock.h"
+#include "../util/SpscQueue.h"
 
 namespace imu {
 
@@ -12,31 +17,76 @@ class ImuReader {
 public:
     explicit ImuReader(m5::IMU_Class& m5);
     bool initialize();
-    bool writeGyroOffset(float x, float y, float z);
+    // Read through the IMU's FIFO instead of polling single samples
+    bool enableFifo(uint16_t sampleRateHz);
+    bool isFifoEnabled() const { return fifo.isEnabled(); }
+    // Nominal sample rate of the IMU and the AHRS, also reprograms the FIFO
+    bool setSampleRate(uint16_t sampleRateHz);
+    uint16_t getSampleRate() const { return (uint16_t) pipeline.getSampleRate(); }
+    // Orientation filter, can be switched while running
+    bool setAhrs(AhrsType type) { return pipeline.setAhrs(type); }
+    AhrsType getAhrsType() const { return pipeline.getAhrsType(); }
+    Ahrs& getAhrs() { return pipeline.getAhrs(); }
+    // Feedback gains of the selected AHRS, can be changed while running
+    void setAhrsGains(float kp, float ki) { pipeline.getAhrs().setGains(kp, ki); }
+    float getAhrsKp() { return pipeline.getAhrs().getKp(); }
+    float getAhrsKi() { return pipeline.getAhrs().getKi(); }
+    uint32_t getFifoOverflowCount() const { return fifo.getOverflowCount(); }
+    bool writeGyroOffset(float x, float y, float z) { return pipeline.writeGyroOffset(x, y, z); }
+    // Keep the gyro offset up to date from the moments the device lies still
+    void enableGyroBiasTracking(bool enable);
+    bool isGyroBiasTracking() const { return pipeline.isGyroBiasTracking(); }
+    const GyroBiasTracker& getGyroBiasTracker() const { return pipeline.getGyroBiasTracker(); }
+    // Taps found by the IMU task, for one consumer task
+    bool popTapEvent(TapEvent& event) { return pipeline.popTapEvent(event); }
+    void setTapThreshold(float threshold) { pipeline.getTapDetector().setThreshold(threshold); }
+    // lowest tempo of the movement, the range is one octave above it
+    void setMinTempo(float bpm) { pipeline.getTempoTracker().setMinTempo(bpm); }
+    // motion descriptors per second, 1 - 50
+    void setMotionFeatureRate(float rate) { pipeline.getMotionFeatures().setRate(rate); }
+    // Gesture templates. Loading is only safe before the IMU task runs, the
+    // other changes are carried out by the IMU task on its next sample. The
+    // templates belong to the IMU task, a recorded one is handed out as a copy.
+    void loadGesture(int slot, const GestureTemplate& gesture) { pipeline.getGestureRecognizer().setTemplate(slot, gesture); }
+    bool recordGesture(int slot);
+    bool clearGesture(int slot);
+    bool setGestureThreshold(int slot, uint16_t threshold);
+    // Gestures matched or recorded by the IMU task, for one consumer task
+    bool popGestureEvent(GestureEvent& event) { return pipeline.popGestureEvent(event); }
+    bool popRecordedGesture(RecordedGesture& recorded) { return pipeline.popRecordedGesture(recorded); }
+    // Raw samples are also handed to the recorder while it records
+    void setTraceRecorder(TraceRecorder* recorder) { trace = recorder; }
     bool update();
-    bool read(ImuData& outImuData) const;
+    // Consistent copy of the latest frame, never blocks the IMU task.
+    // Returns false when nothing was published since version, which is
+    // updated to the version of the copy.
+    bool read(ImuData& outImuData, uint32_t& version) const;
     
+    // Use the current orientation as zero, applied by the IMU task
     void setZero();
 
-    void QuaternionToEuler(float& q0, float& q1, float& q2, float& q3,  float& pitch, float& roll, float& yaw);
-    
-    void quatMultiply (
-        float q0a, float q1a, float q2a, float q3a,
-        float q0b, float q1b, float q2b, float q3b,
-        float &q0, float &q1, float &q2, float &q3);
-
 private:
-    m5::IMU_Class& m5Imu;
-    mahony::MahonyAHRS ahrs;
-    ImuData imuData;
-    ImuData imuDataRef;
+    static const int MaxSamplesPerUpdate = 64;
 
-    uint32_t lastUpdated;
-    long sampleCounter = 0;
-    float gyroOffsets[ImuXyz];
+    struct GestureCommand {
+        enum Type { RECORD, CLEAR, THRESHOLD } type;
+        int slot;
+        uint16_t threshold;
+    };
 
-    float qref[4];  // reference quaternion
-    bool zeroRefSet = false;
+    void processSample(const ImuSample& sample);
+    bool sendGestureCommand(GestureCommand::Type type, int slot, uint16_t threshold);
+
+    m5::IMU_Class& m5Imu;
+    Mpu6886Fifo fifo;
+    ImuSample samples[MaxSamplesPerUpdate];
+    ImuPipeline pipeline;
+    TraceRecorder* trace = nullptr;
+    SeqLock<ImuData> published;
+    // requests from other tasks, carried out by the IMU task
+    std::atomic<bool> zeroRequested;
+    std::atomic<int> biasTrackingRequest;   // -1 none, 0 off, 1 on
+    SpscQueue<GestureCommand, 8> gestureCommands;
 };
 
 } // imu
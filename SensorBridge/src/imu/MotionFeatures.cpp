@@ -0,0 +1,172 @@
+#include <string.h>
+#include <math.h>
+#include "MotionFeatures.h"
+#include "../yin/fft.h"
+
+namespace imu {
+
+    // bins of 50 / 64 Hz
+    const int MotionFeatures::BandStart[Bands + 1] = { 1, 3, 8, WindowFrames / 2 };
+
+    MotionFeatures::MotionFeatures() : publishPeriod(50000) {
+        // complex FFT of half the size, the real one is split from it
+        fft = fft_new(WindowFrames / 2);
+        for (int i = 0; i < WindowFrames; i++) {
+            hann[i] = 0.5f - 0.5f * cosf(2.0f * (float) M_PI * i / WindowFrames);
+        }
+        reset();
+    }
+
+    MotionFeatures::~MotionFeatures() {
+        if (fft != nullptr) fft_destroy(fft);
+    }
+
+    void MotionFeatures::setRate(float rate) {
+        if (!(rate >= 1.0f)) rate = 1.0f;
+        if (rate > 50.0f) rate = 50.0f;
+        publishPeriod = (int64_t) (1e6f / rate);
+    }
+
+    void MotionFeatures::reset() {
+        frameEnd = 0;
+        frameSamples = 0;
+        memset(sum, 0, sizeof(sum));
+        memset(ring, 0, sizeof(ring));
+        frameCount = 0;
+        energySum = 0;
+        memset(axisSum, 0, sizeof(axisSum));
+        jerkSum = 0;
+        nextPublish = 0;
+        publishPending = false;
+        energy = 0.0f;
+        jerk = 0.0f;
+        frequency = 0.0f;
+        memset(bands, 0, sizeof(bands));
+    }
+
+    void MotionFeatures::push(int64_t timestamp, const float* acc, const float* quat) {
+        // the descriptors of the last frame, on the sample after it
+        if (publishPending) {
+            publishPending = false;
+            publish();
+        }
+
+        if (frameEnd == 0 || timestamp - frameEnd > FramePeriod) {
+            // first sample or a gap: start the grid again, the window carries on
+            frameEnd = timestamp + FramePeriod;
+            frameSamples = 0;
+            memset(sum, 0, sizeof(sum));
+        }
+        if (timestamp >= frameEnd && frameSamples > 0) {
+            closeFrame();
+            frameEnd += FramePeriod;
+            if (timestamp >= nextPublish) {
+                publishPending = true;
+                nextPublish = (timestamp - nextPublish > publishPeriod) ? timestamp + publishPeriod : nextPublish + publishPeriod;
+            }
+        }
+
+        // gravity in the sensor frame from the orientation, as the AHRS estimates it
+        const float qw = quat[0], qx = quat[1], qy = quat[2], qz = quat[3];
+        sum[0] += acc[0] - 2.0f * (qx * qz - qw * qy);
+        sum[1] += acc[1] - 2.0f * (qw * qx + qy * qz);
+        sum[2] += acc[2] - (qw * qw - qx * qx - qy * qy + qz * qz);
+        frameSamples++;
+    }
+
+    void MotionFeatures::closeFrame() {
+        int32_t x[3];
+        for (int i = 0; i < 3; i++) {
+            float mean = sum[i] / frameSamples;
+            int value = (int) (mean * Scale + (mean >= 0.0f ? 0.5f : -0.5f));
+            if (value > Limit) value = Limit;
+            if (value < -Limit) value = -Limit;
+            x[i] = value;
+            sum[i] = 0.0f;
+        }
+        frameSamples = 0;
+
+        // the new frame and its difference to the one before come in, the
+        // oldest frame and the difference after it go out
+        int64_t in = 0, out = 0, jerkIn = 0, jerkOut = 0;
+        for (int i = 0; i < 3; i++) {
+            int32_t oldest = frameAt(WindowFrames - 1, i);
+            int32_t step = x[i] - frameAt(0, i);
+            int32_t oldestStep = frameAt(WindowFrames - 2, i) - oldest;
+            in += x[i] * x[i];
+            out += oldest * oldest;
+            axisSum[i] += x[i] - oldest;
+            jerkIn += step * step;
+            jerkOut += oldestStep * oldestStep;
+        }
+        energySum += in - out;
+        jerkSum += jerkIn - jerkOut;
+        int16_t* frame = ring[frameCount & (WindowFrames - 1)];
+        for (int i = 0; i < 3; i++) {
+            frame[i] = (int16_t) x[i];
+        }
+        frameCount++;
+    }
+
+    void MotionFeatures::publish() {
+        // E[x^2] - E[x]^2 summed over the axes, the mean is what the
+        // bands leave out too
+        float variance = (float) energySum / WindowFrames;
+        for (int i = 0; i < 3; i++) {
+            float mean = (float) axisSum[i] / WindowFrames;
+            variance -= mean * mean;
+        }
+        energy = variance > 0.0f ? sqrtf(variance) / Scale : 0.0f;
+        jerk = sqrtf((float) jerkSum / (WindowFrames - 1)) / Scale * (1e6f / FramePeriod);
+        if (fft == nullptr) return;
+
+        // power spectrum summed over the axes, the magnitude would fold a
+        // back and forth movement to twice its rate
+        memset(power, 0, sizeof(power));
+        for (int axis = 0; axis < 3; axis++) {
+            // oldest frame first, without the axis' mean
+            float mean = 0.0f;
+            for (int j = 0; j < WindowFrames; j++) {
+                spectrum[j] = frameAt(WindowFrames - 1 - j, axis) * (1.0f / Scale);
+                mean += spectrum[j];
+            }
+            mean *= 1.0f / WindowFrames;
+            for (int j = 0; j < WindowFrames; j++) {
+                spectrum[j] = (spectrum[j] - mean) * hann[j];
+            }
+            fft_forward_real(fft, spectrum);
+            // bin 0 is real, spectrum[1] holds the Nyquist bin
+            power[0] += spectrum[0] * spectrum[0];
+            for (int k = 1; k < WindowFrames / 2; k++) {
+                power[k] += spectrum[2 * k] * spectrum[2 * k] + spectrum[2 * k + 1] * spectrum[2 * k + 1];
+            }
+        }
+
+        // band RMS: 2 |X|^2 / (N * sum of w^2) per bin, sum of w^2 is 3N / 8
+        const float scale = 2.0f / (WindowFrames * WindowFrames * 0.375f);
+        float total = 0.0f;
+        int peak = BandStart[0];
+        for (int band = 0; band < Bands; band++) {
+            float bandPower = 0.0f;
+            for (int k = BandStart[band]; k < BandStart[band + 1]; k++) {
+                if (power[k] > power[peak]) peak = k;
+                bandPower += power[k];
+            }
+            bands[band] = sqrtf(bandPower * scale);
+            total += bandPower * scale;
+        }
+
+        if (sqrtf(total) < MinEnergy) {
+            frequency = 0.0f;
+            return;
+        }
+        // the peak refined between its neighbours, bin 0 only has the window's leakage
+        float offset = 0.0f;
+        if (peak + 1 < WindowFrames / 2) {
+            float curvature = power[peak - 1] - 2.0f * power[peak] + power[peak + 1];
+            if (curvature < 0.0f) offset = 0.5f * (power[peak - 1] - power[peak + 1]) / curvature;
+        }
+        frequency = (peak + offset) * (1e6f / FramePeriod) / WindowFrames;
+    }
+
+} // imu
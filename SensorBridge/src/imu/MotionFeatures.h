@@ -0,0 +1,82 @@
+#ifndef __IMU_MOTION_FEATURES_H__
+#define __IMU_MOTION_FEATURES_H__
+
+#include <stdint.h>
+
+struct Fft;
+
+namespace imu {
+
+// Descriptors of the movement of the last 1.28 s, for continuous mappings:
+// how much the device moves (RMS of the acceleration without gravity about
+// its mean over the window, so a tilt error of the AHRS reads 0 at rest), how
+// abruptly (RMS jerk), at what rate (the dominant frequency) and the energy
+// in three frequency bands. The acceleration without gravity is averaged
+// into frames of 20 ms on a fixed grid and quantized to 1/256 g, the energy
+// and jerk sums over the window are kept up to date frame by frame in
+// integers. The spectrum is the sum of a 64 point real FFT (yin/fft.h,
+// esp-dsp on the ESP32) per axis, Hann windowed, taken at the publish rate
+// on the sample after a frame: a sample does either a frame or the
+// descriptors. The memory is fixed, the FFT is set up once.
+class MotionFeatures {
+public:
+    static const int Bands = 3;     // 0.8 - 1.6 Hz sway, 2.3 - 5.5 Hz steps and shakes, 6.3 - 24 Hz tremor and hits
+
+    MotionFeatures();
+    ~MotionFeatures();
+
+    // descriptors per second, 1 - 50
+    void setRate(float rate);
+    float getRate() const { return 1e6f / publishPeriod; }
+
+    void reset();
+
+    // One sample: accelerometer in g and the AHRS orientation, which gives
+    // the direction of gravity
+    void push(int64_t timestamp, const float* acc, const float* quat);
+
+    float getEnergy() const { return energy; }         // g RMS
+    float getJerk() const { return jerk; }             // g/s RMS
+    float getFrequency() const { return frequency; }   // Hz, 0 at rest
+    float getBand(int band) const { return bands[band]; } // g RMS
+
+private:
+    static const int64_t FramePeriod = 20000;       // us, 50 frames per second
+    static const int WindowFrames = 64;             // the FFT size, 1.28 s
+    static constexpr float Scale = 256.0f;          // per g
+    static const int Limit = 2048;                  // 8 g, the accelerometer's range
+    static constexpr float MinEnergy = 0.02f;       // g RMS, quieter movement has no frequency
+    static const int BandStart[Bands + 1];          // first bin of every band and the end
+
+    void closeFrame();
+    void publish();
+    int frameAt(uint32_t age, int axis) const { return ring[(frameCount - 1 - age) & (WindowFrames - 1)][axis]; }
+
+    Fft* fft;
+    float hann[WindowFrames];
+    float spectrum[WindowFrames];
+    float power[WindowFrames / 2];  // per bin, all axes
+
+    // frame being averaged, frames are on a fixed grid whatever the sample rate
+    int64_t frameEnd;
+    int frameSamples;
+    float sum[3];
+
+    int16_t ring[WindowFrames][3];
+    uint32_t frameCount;
+    int64_t energySum;              // of the squared frames in the window
+    int32_t axisSum[3];             // of the frames in the window, for their mean
+    int64_t jerkSum;                // of the squared frame differences
+    int64_t publishPeriod;          // us
+    int64_t nextPublish;
+    bool publishPending;
+
+    float energy;
+    float jerk;
+    float frequency;
+    float bands[Bands];
+};
+
+} // imu
+
+#endif // __IMU_MOTION_FEATURES_H__
@@ -0,0 +1,117 @@
+#include "Mpu6886Fifo.h"
+
+namespace imu {
+
+    // MPU6886 registers
+    static const uint8_t RegSampleRateDiv = 0x19;
+    static const uint8_t RegConfig = 0x1A;
+    static const uint8_t RegGyroConfig = 0x1B;
+    static const uint8_t RegAccelConfig = 0x1C;
+    static const uint8_t RegAccelConfig2 = 0x1D;
+    static const uint8_t RegFifoEnable = 0x23;
+    static const uint8_t RegUserCtrl = 0x6A;
+    static const uint8_t RegFifoCountH = 0x72;
+    static const uint8_t RegFifoRW = 0x74;
+
+    static const uint32_t I2cFreq = 400000;
+    static const int FifoSize = 1024;
+
+    // +-8 g and +-2000 deg/s, the ranges M5Unified uses as well
+    static const float AccelScale = 1.0f / 4096.0f;
+    static const float GyroScale = 1.0f / 16.4f;
+
+    Mpu6886Fifo::Mpu6886Fifo(m5::I2C_Class& i2c, uint8_t address) : i2c(i2c), address(address) { }
+
+    bool Mpu6886Fifo::writeRegister(uint8_t reg, uint8_t value) {
+        return i2c.writeRegister8(address, reg, value, I2cFreq);
+    }
+
+    bool Mpu6886Fifo::begin(uint16_t sampleRateHz) {
+        if (sampleRateHz < 4) sampleRateHz = 4;
+        if (sampleRateHz > 1000) sampleRateHz = 1000;
+        uint8_t divider = (uint8_t)(1000 / sampleRateHz - 1);
+        sampleRate = 1000 / (divider + 1);
+        period = 1000000 / sampleRate;
+
+        bool ok = writeRegister(RegFifoEnable, 0x00)
+            && writeRegister(RegUserCtrl, 0x00)
+            && writeRegister(RegSampleRateDiv, divider)
+            && writeRegister(RegConfig, 0x41)      // stop writing when full (keeps frames aligned), DLPF 176 Hz
+            && writeRegister(RegGyroConfig, 0x18)  // +-2000 deg/s
+            && writeRegister(RegAccelConfig, 0x10) // +-8 g
+            && writeRegister(RegAccelConfig2, 0x00)
+            && writeRegister(RegFifoEnable, 0x18); // gyro (and temperature) + accel
+        if (!ok) return false;
+
+        resetFifo();
+        enabled = true;
+        return true;
+    }
+
+    void Mpu6886Fifo::end() {
+        writeRegister(RegFifoEnable, 0x00);
+        writeRegister(RegUserCtrl, 0x04);
+        enabled = false;
+    }
+
+    void Mpu6886Fifo::resetFifo() {
+        writeRegister(RegUserCtrl, 0x04); // FIFO reset
+        writeRegister(RegUserCtrl, 0x40); // FIFO enable
+        epochSet = false;
+        sampleIndex = 0;
+    }
+
+    int Mpu6886Fifo::read(ImuSample* samples, int maxSamples) {
+        if (!enabled) return 0;
+
+        int64_t readTime = esp_timer_get_time();
+        uint8_t countBytes[2];
+        if (!i2c.readRegister(address, RegFifoCountH, countBytes, 2, I2cFreq)) return 0;
+        int fifoBytes = ((countBytes[0] & 0x1F) << 8) | countBytes[1];
+
+        if (fifoBytes > FifoSize - FrameSize) {
+            // samples were lost, start over on a clean frame boundary
+            overflowCount++;
+            resetFifo();
+            return 0;
+        }
+
+        int pending = fifoBytes / FrameSize;
+        if (pending == 0) return 0;
+
+        if (!epochSet) {
+            // the newest pending sample was taken about now
+            epoch = readTime - (int64_t)(pending - 1) * period;
+            epochSet = true;
+        } else {
+            // follow the IMU clock: keep the newest sample within one period before the read
+            int64_t newest = epoch + (sampleIndex + pending - 1) * period;
+            int64_t error = readTime - newest - period / 2;
+            epoch += error / 64;
+        }
+
+        int count = 0;
+        while (count < maxSamples && pending > 0) {
+            int batch = pending;
+            if (batch > MaxBurst) batch = MaxBurst;
+            if (batch > maxSamples - count) batch = maxSamples - count;
+            if (!i2c.readRegister(address, RegFifoRW, burst, batch * FrameSize, I2cFreq)) break;
+
+            for (int i = 0; i < batch; i++) {
+                const uint8_t* frame = &burst[i * FrameSize];
+                ImuSample& sample = samples[count++];
+                for (int axis = 0; axis < ImuXyz; axis++) {
+                    int16_t acc = (int16_t)((frame[axis * 2] << 8) | frame[axis * 2 + 1]);
+                    int16_t gyro = (int16_t)((frame[8 + axis * 2] << 8) | frame[8 + axis * 2 + 1]);
+                    sample.acc[axis] = acc * AccelScale;
+                    sample.gyro[axis] = gyro * GyroScale;
+                }
+                sample.timestamp = epoch + sampleIndex * period;
+                sampleIndex++;
+            }
+            pending -= batch;
+        }
+        return count;
+    }
+
+} // imu
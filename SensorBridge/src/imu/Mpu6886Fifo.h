@@ -0,0 +1,52 @@
+#ifndef __IMU_MPU6886_FIFO_H__
+#define __IMU_MPU6886_FIFO_H__
+
+#include <M5Unified.h>
+#include "ImuData.h"
+
+namespace imu {
+
+// Reads the MPU6886 through its on-chip FIFO: the IMU samples on its own
+// clock, all pending samples are fetched in one I2C burst and stamped on the
+// IMU sample clock, so a late task costs latency instead of samples.
+class Mpu6886Fifo {
+public:
+    static const uint8_t DefaultAddress = 0x68;
+    static const int FrameSize = 14;  // accel xyz, temperature, gyro xyz
+    static const int MaxBurst = 32;   // samples per I2C transaction
+
+    explicit Mpu6886Fifo(m5::I2C_Class& i2c, uint8_t address = DefaultAddress);
+
+    // Configures sample rate (4..1000 Hz), ranges and starts the FIFO
+    bool begin(uint16_t sampleRateHz);
+    void end();
+
+    // Reads up to maxSamples pending samples, returns how many were read
+    int read(ImuSample* samples, int maxSamples);
+
+    bool isEnabled() const { return enabled; }
+    uint16_t getSampleRate() const { return sampleRate; }
+    uint32_t getOverflowCount() const { return overflowCount; }
+
+private:
+    m5::I2C_Class& i2c;
+    uint8_t address;
+    bool enabled = false;
+    uint16_t sampleRate = 0;
+
+    // sample clock: sample n was taken at epoch + n * period
+    int64_t epoch = 0;
+    int64_t sampleIndex = 0;
+    int32_t period = 0;
+    bool epochSet = false;
+    uint32_t overflowCount = 0;
+
+    uint8_t burst[FrameSize * MaxBurst];
+
+    bool writeRegister(uint8_t reg, uint8_t value);
+    void resetFifo();
+};
+
+} // imu
+
+#endif // __IMU_MPU6886_FIFO_H__
@@ -0,0 +1,55 @@
+#ifndef __IMU_RUNNING_STATS_H__
+#define __IMU_RUNNING_STATS_H__
+
+#include <math.h>
+
+namespace imu {
+
+// Streaming mean and variance (Welford's algorithm), constant memory
+class RunningStats {
+public:
+    explicit RunningStats() { reset(); }
+    void push(float x) {
+        cnt++;
+        float delta = x - avg;
+        avg += delta / (float)cnt;
+        m2 += delta * (x - avg);
+    }
+    float mean() const { return avg; }
+    float variance() const { return cnt > 1 ? m2 / (float)(cnt - 1) : 0.0f; }
+    float stddev() const { return sqrtf(variance()); }
+    // standard error of the mean
+    float stderrMean() const { return cnt > 1 ? sqrtf(variance() / (float)cnt) : INFINITY; }
+    int count() const { return cnt; }
+    void reset() {
+        cnt = 0;
+        avg = 0.0f;
+        m2 = 0.0f;
+    }
+private:
+    int cnt;
+    float avg;
+    float m2;   // sum of squared differences from the mean
+};
+
+class RunningStatsXYZ {
+public:
+    explicit RunningStatsXYZ() { }
+    void push(float x, float y, float z) { statsX.push(x); statsY.push(y); statsZ.push(z); }
+    float meanX() const { return statsX.mean(); }
+    float meanY() const { return statsY.mean(); }
+    float meanZ() const { return statsZ.mean(); }
+    // largest of the three
+    float maxStddev() const { return fmaxf(statsX.stddev(), fmaxf(statsY.stddev(), statsZ.stddev())); }
+    float maxStderrMean() const { return fmaxf(statsX.stderrMean(), fmaxf(statsY.stderrMean(), statsZ.stderrMean())); }
+    int count() const { return statsX.count(); }
+    void reset() { statsX.reset(); statsY.reset(); statsZ.reset(); }
+private:
+    RunningStats statsX;
+    RunningStats statsY;
+    RunningStats statsZ;
+};
+
+} // imu
+
+#endif // __IMU_RUNNING_STATS_H__
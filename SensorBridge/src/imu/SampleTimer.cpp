@@ -0,0 +1,92 @@
+#include "SampleTimer.h"
+#include <math.h>
+
+namespace imu {
+
+    SampleTimer::SampleTimer() { }
+
+    SampleTimer::~SampleTimer() {
+        end();
+    }
+
+    void SampleTimer::onTimer(void* arg) {
+        SampleTimer* self = (SampleTimer*) arg;
+        xTaskNotifyGive(self->task);
+    }
+
+    bool SampleTimer::begin(TaskHandle_t task, uint32_t rateHz) {
+        this->task = task;
+        if (timer == nullptr) {
+            esp_timer_create_args_t args = {};
+            args.callback = &SampleTimer::onTimer;
+            args.arg = this;
+            args.dispatch_method = ESP_TIMER_TASK;
+            args.name = "imu_sample";
+            if (esp_timer_create(&args, &timer) != ESP_OK) {
+                timer = nullptr;
+                return false;
+            }
+        }
+        return setRate(rateHz);
+    }
+
+    bool SampleTimer::setRate(uint32_t rateHz) {
+        if (timer == nullptr || rateHz == 0) return false;
+        esp_timer_stop(timer); // fails harmlessly when not running
+        rate = rateHz;
+        period = 1000000 / rateHz;
+        resetStats();
+        return esp_timer_start_periodic(timer, period) == ESP_OK;
+    }
+
+    void SampleTimer::end() {
+        if (timer == nullptr) return;
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+        timer = nullptr;
+    }
+
+    int64_t SampleTimer::wait() {
+        // a count above one means periods were missed, they are not replayed
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        int64_t now = esp_timer_get_time();
+
+        if (pending > 1) missed += pending - 1;
+        if (lastWake != 0 && pending > 0) {
+            int32_t interval = (int32_t)(now - lastWake);
+            int32_t deviation = abs(interval - period);
+            count++;
+            sumInterval += interval;
+            sumIntervalSq += (double) interval * interval;
+            if (deviation > maxDeviation) maxDeviation = deviation;
+        }
+        lastWake = now;
+        return now;
+    }
+
+    SampleTimer::Stats SampleTimer::getStats() const {
+        Stats stats;
+        stats.count = count;
+        stats.missed = missed;
+        stats.maxDeviation = maxDeviation;
+        if (count > 0) {
+            double mean = sumInterval / count;
+            double variance = sumIntervalSq / count - mean * mean;
+            stats.meanInterval = (float) mean;
+            stats.jitter = variance > 0 ? (float) sqrt(variance) : 0.0f;
+        } else {
+            stats.meanInterval = 0.0f;
+            stats.jitter = 0.0f;
+        }
+        return stats;
+    }
+
+    void SampleTimer::resetStats() {
+        count = 0;
+        sumInterval = 0;
+        sumIntervalSq = 0;
+        maxDeviation = 0;
+        missed = 0;
+    }
+
+} // imu
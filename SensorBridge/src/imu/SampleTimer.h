@@ -0,0 +1,55 @@
+#ifndef __IMU_SAMPLE_TIMER_H__
+#define __IMU_SAMPLE_TIMER_H__
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+namespace imu {
+
+// Wakes a task at an exact rate from a periodic esp_timer instead of
+// vTaskDelay, which only has 1 ms tick resolution. Also measures how
+// late the task actually wakes up.
+class SampleTimer {
+public:
+    struct Stats {
+        uint32_t count;       // wake ups since the last reset
+        float meanInterval;   // us
+        float jitter;         // standard deviation of the interval, us
+        int32_t maxDeviation; // largest difference from the nominal period, us
+        uint32_t missed;      // periods that passed without a wake up
+    };
+
+    SampleTimer();
+    ~SampleTimer();
+
+    // Start notifying the given task, rate in Hz (200, 400, 1000, ...)
+    bool begin(TaskHandle_t task, uint32_t rateHz);
+    bool setRate(uint32_t rateHz);
+    uint32_t getRate() const { return rate; }
+    void end();
+
+    // Block the calling (notified) task until the next period, returns the wake up time
+    int64_t wait();
+
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    static void onTimer(void* arg);
+
+    esp_timer_handle_t timer = nullptr;
+    TaskHandle_t task = nullptr;
+    uint32_t rate = 0;
+    int32_t period = 0;
+
+    int64_t lastWake = 0;
+    uint32_t count = 0;
+    double sumInterval = 0;
+    double sumIntervalSq = 0;
+    int32_t maxDeviation = 0;
+    uint32_t missed = 0;
+};
+
+} // imu
+
+#endif // __IMU_SAMPLE_TIMER_H__
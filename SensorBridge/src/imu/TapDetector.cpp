@@ -0,0 +1,75 @@
+#include <math.h>
+#include "TapDetector.h"
+
+namespace imu {
+
+    TapDetector::TapDetector() : threshold(1.0f), fullScale(6.0f) {
+        reset();
+    }
+
+    void TapDetector::reset() {
+        rest = 1.0f;
+        state = IDLE;
+        onset = 0;
+        lastTime = 0;
+        lastTap = 0;
+        peak = 0.0f;
+        count = 0;
+    }
+
+    bool TapDetector::push(int64_t timestamp, float ax, float ay, float az, TapEvent& event) {
+        float magnitude = sqrtf(ax * ax + ay * ay + az * az);
+        float excess = fabsf(magnitude - rest);
+        float dt = (lastTime != 0) ? (timestamp - lastTime) * 1e-6f : 0.0f;
+        lastTime = timestamp;
+        bool tap = false;
+
+        switch (state) {
+            case IDLE:
+                if (excess > threshold) {
+                    state = PEAK;
+                    onset = timestamp;
+                    peak = excess;
+                } else if (excess < threshold * ReleaseRatio) {
+                    // follow slow changes of the resting level (scale errors, temperature)
+                    float alpha = dt / (RestTimeConstant + dt);
+                    rest += alpha * (magnitude - rest);
+                }
+                break;
+
+            case PEAK:
+                if (excess > peak) {
+                    peak = excess;
+                }
+                // the peak is over once the signal falls back or the window ends
+                if (excess < peak * ReleaseRatio || timestamp - onset >= PeakWindow) {
+                    bool sameGroup = lastTap != 0 && onset - lastTap < MultiTapWindow;
+                    count = sameGroup ? (count < 255 ? count + 1 : count) : 1;
+                    lastTap = onset;
+
+                    float level = (peak - threshold) / (fullScale - threshold);
+                    if (level < 0.0f) level = 0.0f;
+                    if (level > 1.0f) level = 1.0f;
+                    // square root: soft hits get a usable velocity range
+                    int velocity = 1 + (int) (126.0f * sqrtf(level) + 0.5f);
+
+                    event.timestamp = onset;
+                    event.peak = peak;
+                    event.velocity = (uint8_t) velocity;
+                    event.count = count;
+                    tap = true;
+                    state = SETTLE;
+                }
+                break;
+
+            case SETTLE:
+                // ringing of the same hit is not a new tap
+                if (excess < threshold * ReleaseRatio && timestamp - onset >= Refractory) {
+                    state = IDLE;
+                }
+                break;
+        }
+        return tap;
+    }
+
+} // imu
@@ -0,0 +1,61 @@
+#ifndef __IMU_TAP_DETECTOR_H__
+#define __IMU_TAP_DETECTOR_H__
+
+#include <stdint.h>
+
+namespace imu {
+
+struct TapEvent {
+    int64_t timestamp;  // sample time of the onset, esp_timer microseconds
+    float peak;         // acceleration above gravity at the peak, g
+    uint8_t velocity;   // 1 - 127, from the peak
+    uint8_t count;      // 1 for a single tap, 2 for a double tap, ...
+};
+
+// Finds taps in the accelerometer magnitude at the full sample rate.
+// A tap starts when the acceleration above the resting level crosses the
+// threshold; its peak is followed for a few milliseconds and gives the
+// velocity. The event carries the onset time, so the receiver plays it
+// in time even though it is reported after the peak. After a tap the
+// detector waits for the signal to settle and a refractory time, taps that
+// follow each other closely are counted as double (and multi) taps.
+class TapDetector {
+public:
+    TapDetector();
+
+    // acceleration above the resting level that starts a tap, g
+    void setThreshold(float threshold) { this->threshold = threshold; }
+    float getThreshold() const { return threshold; }
+    // acceleration above the resting level that gives velocity 127, g
+    void setFullScale(float fullScale) { this->fullScale = fullScale; }
+
+    void reset();
+
+    // One sample, accelerometer in g. Returns true and fills event when a
+    // tap is complete.
+    bool push(int64_t timestamp, float ax, float ay, float az, TapEvent& event);
+
+private:
+    static const int64_t PeakWindow = 15000;        // us, longest rise to the peak
+    static const int64_t Refractory = 60000;        // us, no new tap before this
+    static const int64_t MultiTapWindow = 350000;   // us, counts as the same group
+    static constexpr float ReleaseRatio = 0.5f;     // below threshold * ratio the tap is over
+    static constexpr float RestTimeConstant = 1.0f; // s, resting level follows gravity
+
+    enum State { IDLE, PEAK, SETTLE };
+
+    float threshold;
+    float fullScale;
+    float rest;         // resting magnitude, about 1 g
+
+    State state;
+    int64_t onset;
+    int64_t lastTime;
+    int64_t lastTap;
+    float peak;
+    uint8_t count;
+};
+
+} // imu
+
+#endif // __IMU_TAP_DETECTOR_H__
@@ -0,0 +1,164 @@
+#include <string.h>
+#include <math.h>
+#include "TempoTracker.h"
+#include "../yin/yin_common.h"
+
+namespace imu {
+
+    TempoTracker::TempoTracker() : minTempo(80.0f) {
+        reset();
+    }
+
+    void TempoTracker::reset() {
+        frameEnd = 0;
+        frameSamples = 0;
+        sum = 0.0f;
+        memset(ring, 0, sizeof(ring));
+        frameCount = 0;
+        frameTime = 0;
+        memset(difference, 0, sizeof(difference));
+        windowSum = 0;
+        windowSquares = 0;
+        analysisPending = false;
+        tempo = 0.0f;
+        confidence = 0.0f;
+        candidate = 0.0f;
+        candidateCount = 0;
+        beatTime = 0;
+    }
+
+    void TempoTracker::push(int64_t timestamp, float ax, float ay, float az) {
+        // the estimate of the last frame, on the sample after it
+        if (analysisPending) {
+            analysisPending = false;
+            analyze();
+        }
+
+        if (frameEnd == 0 || timestamp - frameEnd > FramePeriod) {
+            // first sample or a gap: start the grid again, the ring carries on
+            frameEnd = timestamp + FramePeriod;
+            frameSamples = 0;
+            sum = 0.0f;
+        }
+        if (timestamp >= frameEnd && frameSamples > 0) {
+            closeFrame();
+            frameEnd += FramePeriod;
+        }
+        sum += sqrtf(ax * ax + ay * ay + az * az) - 1.0f;
+        frameSamples++;
+    }
+
+    void TempoTracker::closeFrame() {
+        float mean = sum / frameSamples;
+        sum = 0.0f;
+        frameSamples = 0;
+        int value = (int) (mean * Scale + (mean >= 0.0f ? 0.5f : -0.5f));
+        if (value > Limit) value = Limit;
+        if (value < -Limit) value = -Limit;
+        const int32_t x = value;
+        frameTime = frameEnd - FramePeriod / 2;
+
+        // d(tau) over the newest WindowFrames frames: the new frame's term
+        // comes in, the one of the frame leaving the window goes out
+        const int32_t leaving = frameAt(WindowFrames - 1);
+        for (int tau = 1; tau < WindowFrames; tau++) {
+            int32_t in = x - frameAt(tau - 1);
+            int32_t out = leaving - frameAt(WindowFrames - 1 + tau);
+            difference[tau] += in * in - out * out;
+        }
+        windowSum += x - leaving;
+        windowSquares += x * x - leaving * leaving;
+        ring[frameCount & (RingFrames - 1)] = (int16_t) x;
+        frameCount++;
+
+        if (tempo > 0.0f) {
+            // on to the beat this frame is in
+            float period = 60e6f / tempo;
+            if (frameTime - beatTime >= period) {
+                beatTime += (int64_t) floorf((frameTime - beatTime) / period) * (int64_t) period;
+            }
+            // the frame before is a peak well above the window's mean
+            float windowMean = (float) windowSum / WindowFrames;
+            float variance = (float) windowSquares / WindowFrames - windowMean * windowMean;
+            float peak = frameAt(1) - windowMean;
+            if (frameAt(1) > frameAt(2) && frameAt(1) >= frameAt(0) && peak > 0.0f && peak * peak > variance) {
+                followPeak(frameTime - FramePeriod);
+            }
+        }
+        // the ring holds the window and all its lags
+        analysisPending = frameCount >= (uint32_t) RingFrames;
+    }
+
+    void TempoTracker::followPeak(int64_t peakTime) {
+        // error to the nearest beat, -0.5 - 0.5 beats; peaks between the
+        // beats (the other step, an octave folded away) are left out
+        float period = 60e6f / tempo;
+        float error = (peakTime - beatTime) / period;
+        error -= floorf(error + 0.5f);
+        if (fabsf(error) < 0.25f) {
+            beatTime += (int64_t) (PhaseGain * error * period);
+        }
+    }
+
+    void TempoTracker::analyze() {
+        float windowMean = (float) windowSum / WindowFrames;
+        float variance = (float) windowSquares / WindowFrames - windowMean * windowMean;
+        float probability = 0.0f;
+        int tau = -1;
+        if (variance >= MinVariance) {
+            tau = yin_absolute_threshold(difference, WindowFrames, Threshold, &probability);
+        }
+        confidence += ConfidenceRate * (probability - confidence);
+        if (tau < 0) {
+            candidateCount = 0;
+            return;
+        }
+
+        float period = yin_parabolic_interpolation(difference, WindowFrames, tau);
+        float bpm = 60e6f / (period * FramePeriod);
+        while (bpm < minTempo) bpm *= 2.0f;
+        while (bpm >= 2.0f * minTempo) bpm *= 0.5f;
+
+        if (tempo <= 0.0f) {
+            tempo = bpm;
+            findBeat();
+            return;
+        }
+        // at the ends of the octave an estimate may fold to the other one
+        if (bpm > 1.5f * tempo) bpm *= 0.5f;
+        else if (bpm < 0.75f * tempo) bpm *= 2.0f;
+
+        if (fabsf(bpm - tempo) < Tolerance * tempo) {
+            tempo += Smoothing * (bpm - tempo);
+            candidateCount = 0;
+        } else if (candidateCount > 0 && fabsf(bpm - candidate) < Tolerance * candidate) {
+            candidate += Smoothing * (bpm - candidate);
+            if (++candidateCount >= ChangeEstimates) {
+                tempo = candidate;
+                candidateCount = 0;
+                findBeat();
+            }
+        } else {
+            candidate = bpm;
+            candidateCount = 1;
+        }
+    }
+
+    void TempoTracker::findBeat() {
+        // the strongest frame of the last beat, the phase locked loop takes it from there
+        int frames = (int) (60e6f / (tempo * FramePeriod) + 0.5f);
+        if (frames > RingFrames) frames = RingFrames;
+        int strongest = 0;
+        for (int age = 1; age < frames; age++) {
+            if (frameAt(age) > frameAt(strongest)) strongest = age;
+        }
+        beatTime = frameTime - strongest * FramePeriod;
+    }
+
+    float TempoTracker::getPhase(int64_t timestamp) const {
+        if (tempo <= 0.0f) return 0.0f;
+        float beats = (timestamp - beatTime) * tempo / 60e6f;
+        return beats - floorf(beats);
+    }
+
+} // imu
@@ -0,0 +1,87 @@
+#ifndef __IMU_TEMPO_TRACKER_H__
+#define __IMU_TEMPO_TRACKER_H__
+
+#include <stdint.h>
+
+namespace imu {
+
+// Follows the tempo of a periodic movement (bouncing, stepping, swaying)
+// from the accelerometer magnitude. Samples are averaged into frames of
+// 20 ms and quantized to 1/256 g. The YIN difference function of the last
+// 1.28 s is kept up to date frame by frame in integers: every lag gets the
+// newest frame's term added and the oldest one's taken off, exactly, so
+// there is no drift. The sample after a frame runs the YIN threshold and
+// interpolation (yin/yin_common.h) on it; the cost of a sample stays
+// bounded by one of the two steps.
+//
+// The period is folded into one octave of tempo, 80 - 160 BPM by default,
+// and followed smoothly; a different tempo is taken over once it was found
+// for half a second. The beat phase is kept by a simple phase locked
+// loop on the peaks of the movement near the expected beat.
+class TempoTracker {
+public:
+    TempoTracker();
+
+    // lowest tempo reported, the range is one octave above it
+    void setMinTempo(float bpm) { minTempo = bpm; }
+    float getMinTempo() const { return minTempo; }
+
+    void reset();
+
+    // One sample, accelerometer in g
+    void push(int64_t timestamp, float ax, float ay, float az);
+
+    // BPM, the last one found or 0 before the first
+    float getTempo() const { return tempo; }
+    // 0 - 1, how periodic the movement is; 0 at rest
+    float getConfidence() const { return confidence; }
+    // 0 - 1 of the beat at timestamp, 0 on the beat
+    float getPhase(int64_t timestamp) const;
+    // sample time of the last beat, 0 before the first
+    int64_t getBeatTime() const { return beatTime; }
+
+private:
+    static const int64_t FramePeriod = 20000;       // us, 50 frames per second
+    static const int WindowFrames = 64;             // longest period, 1.28 s or 47 BPM
+    static const int RingFrames = 2 * WindowFrames; // the window and its lags
+    static constexpr float Scale = 256.0f;          // per g
+    static const int Limit = 1024;                  // 4 g, a lag difference squared fits 23 bits
+    static constexpr float Threshold = 0.35f;       // YIN, movement is less periodic than sound
+    static const int32_t MinVariance = 164;         // (0.05 g)^2, quieter movement has no tempo
+    static constexpr float Tolerance = 0.08f;       // of the tempo, closer estimates are followed
+    static constexpr float Smoothing = 0.05f;       // per estimate, one per frame
+    static const int ChangeEstimates = 25;          // agreeing estimates that change the tempo, 0.5 s
+    static constexpr float ConfidenceRate = 0.1f;   // per estimate, about 200 ms
+    static constexpr float PhaseGain = 0.2f;        // of the beat error, per peak
+
+    void closeFrame();
+    void followPeak(int64_t peakTime);
+    void analyze();
+    void findBeat();
+    int16_t frameAt(uint32_t age) const { return ring[(frameCount - 1 - age) & (RingFrames - 1)]; }
+
+    float minTempo;
+
+    // frame being averaged, frames are on a fixed grid whatever the sample rate
+    int64_t frameEnd;
+    int frameSamples;
+    float sum;
+
+    int16_t ring[RingFrames];
+    uint32_t frameCount;
+    int64_t frameTime;              // middle of the newest frame
+    int32_t difference[WindowFrames];
+    int32_t windowSum;              // of the frames in the window, for the variance
+    int32_t windowSquares;
+    bool analysisPending;
+
+    float tempo;
+    float confidence;
+    float candidate;                // a different tempo, found candidateCount times
+    int candidateCount;
+    int64_t beatTime;
+};
+
+} // imu
+
+#endif // __IMU_TEMPO_TRACKER_H__
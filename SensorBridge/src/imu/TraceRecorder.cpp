@@ -0,0 +1,59 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TraceRecorder.h"
+
+namespace imu {
+
+    void TraceRecorder::start() {
+        dropped = 0;
+        recording = true;
+    }
+
+    void TraceRecorder::stop() {
+        recording = false;
+    }
+
+    void TraceRecorder::push(const ImuSample& sample) {
+        if (!recording) return;
+        if (!queue.push(sample)) {
+            dropped++;
+        }
+    }
+
+    int TraceRecorder::nextLine(char* line, size_t size) {
+        uint32_t lost = dropped.exchange(0);
+        if (lost > 0) {
+            return snprintf(line, size, "# trace dropped %lu\n", (unsigned long) lost);
+        }
+        ImuSample sample;
+        if (!queue.pop(sample)) {
+            return 0;
+        }
+        return formatSample(sample, line, size);
+    }
+
+    int TraceRecorder::formatSample(const ImuSample& sample, char* line, size_t size) {
+        return snprintf(line, size, "T,%" PRId64 ",%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n",
+            sample.timestamp,
+            sample.acc[0], sample.acc[1], sample.acc[2],
+            sample.gyro[0], sample.gyro[1], sample.gyro[2]);
+    }
+
+    bool TraceRecorder::parseSample(const char* line, ImuSample& sample) {
+        if (line[0] != 'T' || line[1] != ',') return false;
+        char* end;
+        const char* p = line + 2;
+        sample.timestamp = strtoll(p, &end, 10);
+        if (end == p || *end != ',') return false;
+        float* values[6] = { &sample.acc[0], &sample.acc[1], &sample.acc[2], &sample.gyro[0], &sample.gyro[1], &sample.gyro[2] };
+        for (int i = 0; i < 6; i++) {
+            p = end + 1;
+            *values[i] = strtof(p, &end);
+            if (end == p) return false;
+            if (i < 5 && *end != ',') return false;
+        }
+        return true;
+    }
+
+} // imu
@@ -0,0 +1,52 @@
+#ifndef __IMU_TRACE_RECORDER_H__
+#define __IMU_TRACE_RECORDER_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include "ImuData.h"
+#include "../util/SpscQueue.h"
+
+namespace imu {
+
+// Records raw IMU samples as text lines, to be replayed on a PC by
+// bench/imu_replay.cpp. One line per sample:
+//
+//   T,<timestamp us>,<ax>,<ay>,<az>,<gx>,<gy>,<gz>
+//
+// accelerometer in g, gyro in deg/s without offset, floats printed with 9
+// significant digits so they read back bit for bit. Other lines in the same
+// log are ignored by the replay, it can be captured together with the rest
+// of the serial output.
+//
+// The IMU task pushes samples without waiting, a lower priority task writes
+// them out. Samples that do not fit are counted and reported as
+// "# trace dropped <n>" lines.
+class TraceRecorder {
+public:
+    TraceRecorder() : recording(false), dropped(0) { }
+
+    void start();
+    void stop();
+    bool isRecording() const { return recording; }
+
+    // from the IMU task
+    void push(const ImuSample& sample);
+
+    // Format pending samples into a line at a time, returns the line length
+    // or 0 when there is nothing to write
+    int nextLine(char* line, size_t size);
+
+    static int formatSample(const ImuSample& sample, char* line, size_t size);
+    // Parse a T line, returns false for any other line
+    static bool parseSample(const char* line, ImuSample& sample);
+
+private:
+    SpscQueue<ImuSample, 256> queue;    // 1.3 s at 200 Hz
+    std::atomic<bool> recording;
+    std::atomic<uint32_t> dropped;
+};
+
+} // imu
+
+#endif // __IMU_TRACE_RECORDER_H__
@@ -0,0 +1,78 @@
+#include <math.h>
+#include "ComplementaryFilter.h"
+
+#define sampleFreqDef	200.0f			// default sample frequency in Hz
+#define maxDt		0.05f			// longest step that is integrated in one go, in s
+#define kpDef		1.0f			// crossover frequency in rad/s
+#define minAccSq	(0.8f * 0.8f)	// accelerometer is trusted between 0.8 and 1.2 g
+#define maxAccSq	(1.2f * 1.2f)
+
+namespace imu {
+namespace complementary {
+
+ComplementaryFilter::ComplementaryFilter() : kp(kpDef) {
+	setSampleRate(sampleFreqDef);
+}
+
+void ComplementaryFilter::setGains(float kp, float /*ki*/) {
+	this->kp = kp;
+}
+
+void ComplementaryFilter::setSampleRate(float sampleFreq) {
+	this->sampleFreq = sampleFreq;
+	this->samplePeriod = 1.0f / sampleFreq;
+	this->minDt = 0.25f * samplePeriod;
+}
+
+void ComplementaryFilter::UpdateQuaternion(float gx, float gy, float gz, float ax, float ay, float az, float dt, float& q0, float& q1, float& q2, float& q3) {
+	float recipNorm;
+	float vx, vy, vz;
+	float qa, qb, qc;
+	float halfDt;
+
+	// Use the measured step, fall back to the nominal period for outliers
+	if (!(dt >= minDt)) {
+		dt = samplePeriod;
+	} else if (dt > maxDt) {
+		dt = maxDt;
+	}
+
+	// Only close to 1 g the accelerometer measures the direction of gravity,
+	// which also keeps its magnitude close enough to 1 to skip normalising it
+	float accSq = ax * ax + ay * ay + az * az;
+	if (accSq > minAccSq && accSq < maxAccSq) {
+
+		// Estimated direction of gravity
+		vx = 2.0f * (q1 * q3 - q0 * q2);
+		vy = 2.0f * (q0 * q1 + q2 * q3);
+		vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+		// Turn towards the measured direction of gravity
+		gx += kp * (ay * vz - az * vy);
+		gy += kp * (az * vx - ax * vz);
+		gz += kp * (ax * vy - ay * vx);
+	}
+
+	// Integrate rate of change of quaternion
+	halfDt = 0.5f * dt;
+	gx *= halfDt;
+	gy *= halfDt;
+	gz *= halfDt;
+	qa = q0;
+	qb = q1;
+	qc = q2;
+	q0 += (-qb * gx - qc * gy - q3 * gz);
+	q1 += (qa * gx + qc * gz - q3 * gy);
+	q2 += (qa * gy - qb * gz + q3 * gx);
+	q3 += (qa * gz + qb * gy - qc * gx);
+
+	// Normalise quaternion
+	recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+	q0 *= recipNorm;
+	q1 *= recipNorm;
+	q2 *= recipNorm;
+	q3 *= recipNorm;
+}
+
+} // complementary
+} // imu
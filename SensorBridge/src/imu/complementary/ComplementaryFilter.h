@@ -0,0 +1,46 @@
+#ifndef __IMU_COMPLEMENTARY_FILTER_H__
+#define __IMU_COMPLEMENTARY_FILTER_H__
+
+#include "../Ahrs.h"
+
+namespace imu {
+namespace complementary {
+
+// First order complementary filter: the gyroscope is integrated and the
+// accelerometer tilt is blended in with a fixed crossover. Cheapest of the
+// backends, no integral term and no accelerometer normalisation. Expects the
+// accelerometer in g and ignores it while the device accelerates.
+class ComplementaryFilter : public Ahrs {
+public:
+    ComplementaryFilter();
+
+    const char* name() const override { return "complementary"; }
+
+    // Nominal sample rate, used when a sample has no usable time step
+    void setSampleRate(float sampleFreq) override;
+    float getSampleRate() const override { return sampleFreq; }
+
+    // kp is the crossover frequency in rad/s, ki is not used
+    void setGains(float kp, float ki) override;
+    float getKp() const override { return kp; }
+
+    void reset() override { }
+
+    // dt is the measured time since the previous sample in seconds
+    void UpdateQuaternion(
+        float gx, float gy, float gz,
+        float ax, float ay, float az,
+        float dt,
+        float& q0, float& q1, float& q2, float& q3) override;
+
+private:
+    float sampleFreq;
+    float samplePeriod;
+    float minDt;                                    // shorter steps are timestamp glitches
+    float kp;
+};
+
+} // complementary
+} // imu
+
+#endif // __IMU_COMPLEMENTARY_FILTER_H__
@@ -0,0 +1,44 @@
+#ifndef __IMU_MADGWICK_AHRS_H__
+#define __IMU_MADGWICK_AHRS_H__
+
+#include "../Ahrs.h"
+
+namespace imu {
+namespace madgwick {
+
+// Madgwick's gradient descent orientation filter, IMU (6 axis) variant.
+// Converges faster than Mahony for the same gain, at a higher cost per update.
+class MadgwickAHRS : public Ahrs {
+public:
+    MadgwickAHRS();
+
+    const char* name() const override { return "madgwick"; }
+
+    // Nominal sample rate, used when a sample has no usable time step
+    void setSampleRate(float sampleFreq) override;
+    float getSampleRate() const override { return sampleFreq; }
+
+    // kp is the algorithm gain beta, there is no integral term
+    void setGains(float kp, float ki) override;
+    float getKp() const override { return beta; }
+
+    void reset() override { }
+
+    // dt is the measured time since the previous sample in seconds
+    void UpdateQuaternion(
+        float gx, float gy, float gz,
+        float ax, float ay, float az,
+        float dt,
+        float& q0, float& q1, float& q2, float& q3) override;
+
+private:
+    float sampleFreq;
+    float samplePeriod;
+    float minDt;                                    // shorter steps are timestamp glitches
+    float beta;                                     // 2 * proportional gain
+};
+
+} // madgwick
+} // imu
+
+#endif // __IMU_MADGWICK_AHRS_H__
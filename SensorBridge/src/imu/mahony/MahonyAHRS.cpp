@@ -13,43 +13,52 @@
 // from https://github.com/m5stack/M5StickC/blob/master/src/utility/MahonyAHRS.cpp
 
 #include <math.h>
-//#include <M5StickC.h>
-#include <M5Unified.h>
 #include "MahonyAHRS.h"
 
-#define sampleFreq	200.0f			// sample frequency in Hz
+#define sampleFreqDef	200.0f			// default sample frequency in Hz
+#define maxDt		0.05f			// longest step that is integrated in one go, in s
 #define twoKpDef	(2.0f * 1.0f)	// 2 * proportional gain
 #define twoKiDef	(2.0f * 0.0f)	// 2 * integral gain
 
 namespace imu {
 namespace mahony {
 
-volatile float twoKp = twoKpDef;											// 2 * proportional gain (Kp)
-volatile float twoKi = twoKiDef;											// 2 * integral gain (Ki)
-//volatile float q0 = 1.0, q1 = 0.0, q2 = 0.0, q3 = 0.0;					// quaternion of sensor frame relative to auxiliary frame
-volatile float integralFBx = 0.0f,  integralFBy = 0.0f, integralFBz = 0.0f;	// integral error terms scaled by Ki
-
-//---------------------------------------------------------------------------------------------------
-// Fast inverse square-root
-// See: http://en.wikipedia.org/wiki/Fast_inverse_square_root
-
-float invSqrt(float x) {
-	float halfx = 0.5f * x;
-	float y = x;
-#pragma GCC diagnostic ignored "-Wstrict-aliasing"
-	long i = *(long*)&y;
-	i = 0x5f3759df - (i>>1);
-	y = *(float*)&i;
-#pragma GCC diagnostic warning "-Wstrict-aliasing"
-	y = y * (1.5f - (halfx * y * y));
-	return y;
+MahonyAHRS::MahonyAHRS() : twoKp(twoKpDef), twoKi(twoKiDef) {
+	setSampleRate(sampleFreqDef);
+	reset();
 }
 
-void MahonyAHRS::UpdateQuaternion(float gx, float gy, float gz, float ax, float ay, float az, float& q0, float& q1, float& q2, float& q3) {
+void MahonyAHRS::setGains(float kp, float ki) {
+	twoKp = 2.0f * kp;
+	twoKi = 2.0f * ki;
+}
+
+void MahonyAHRS::reset() {
+	integralFBx = 0.0f;
+	integralFBy = 0.0f;
+	integralFBz = 0.0f;
+}
+
+void MahonyAHRS::setSampleRate(float sampleFreq) {
+	this->sampleFreq = sampleFreq;
+	this->samplePeriod = 1.0f / sampleFreq;
+	this->minDt = 0.25f * samplePeriod;
+}
+
+void MahonyAHRS::UpdateQuaternion(float gx, float gy, float gz, float ax, float ay, float az, float dt, float& q0, float& q1, float& q2, float& q3) {
 	float recipNorm;
 	float halfvx, halfvy, halfvz;
 	float halfex, halfey, halfez;
 	float qa, qb, qc;
+	float halfDt;
+
+	// Use the measured step, fall back to the nominal period for outliers:
+	// no previous sample or a timestamp glitch, and cap long gaps
+	if (!(dt >= minDt)) {
+		dt = samplePeriod;
+	} else if (dt > maxDt) {
+		dt = maxDt;
+	}
 
 	// Compute feedback only if accelerometer measurement valid (avoids NaN in accelerometer normalisation)
 	if(!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
@@ -72,9 +81,10 @@ void MahonyAHRS::UpdateQuaternion(float gx, float gy, float gz, float ax, float
 
 		// Compute and apply integral feedback if enabled
 		if(twoKi > 0.0f) {
-			integralFBx += twoKi * halfex * (1.0f / sampleFreq);	// integral error scaled by Ki
-			integralFBy += twoKi * halfey * (1.0f / sampleFreq);
-			integralFBz += twoKi * halfez * (1.0f / sampleFreq);
+			float twoKiDt = twoKi * dt;
+			integralFBx += twoKiDt * halfex;	// integral error scaled by Ki
+			integralFBy += twoKiDt * halfey;
+			integralFBz += twoKiDt * halfez;
 			gx += integralFBx;	// apply integral feedback
 			gy += integralFBy;
 			gz += integralFBz;
@@ -92,9 +102,10 @@ void MahonyAHRS::UpdateQuaternion(float gx, float gy, float gz, float ax, float
 	}
 
 	// Integrate rate of change of quaternion
-	gx *= (0.5f * (1.0f / sampleFreq));		// pre-multiply common factors
-	gy *= (0.5f * (1.0f / sampleFreq));
-	gz *= (0.5f * (1.0f / sampleFreq));
+	halfDt = 0.5f * dt;		// pre-multiply common factors
+	gx *= halfDt;
+	gy *= halfDt;
+	gz *= halfDt;
 	qa = q0;
 	qb = q1;
 	qc = q2;
@@ -111,9 +122,5 @@ void MahonyAHRS::UpdateQuaternion(float gx, float gy, float gz, float ax, float
 	q3 *= recipNorm;
 }
 
-
-
-
-
 } // mahony
 } // imu
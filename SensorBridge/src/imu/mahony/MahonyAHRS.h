@@ -1,23 +1,43 @@
 #ifndef __IMU_MAHONY_AHRS_H__
 #define __IMU_MAHONY_AHRS_H__
 
-#ifdef imu
-#undef imu
-#endif
+#include "../Ahrs.h"
 
 namespace imu {
 namespace mahony {
 
-class MahonyAHRS {
+class MahonyAHRS : public Ahrs {
 public:
+    MahonyAHRS();
+
+    const char* name() const override { return "mahony"; }
+
+    // Nominal sample rate, used when a sample has no usable time step
+    void setSampleRate(float sampleFreq) override;
+    float getSampleRate() const override { return sampleFreq; }
+
+    // Proportional and integral feedback gains
+    void setGains(float kp, float ki) override;
+    float getKp() const override { return 0.5f * twoKp; }
+    float getKi() const override { return 0.5f * twoKi; }
+
+    // Clear the integral feedback
+    void reset() override;
+
+    // dt is the measured time since the previous sample in seconds
     void UpdateQuaternion(
         float gx, float gy, float gz, 
         float ax, float ay, float az,
-        float& q0, float& q1, float& q2, float& q3);
+        float dt,
+        float& q0, float& q1, float& q2, float& q3) override;
 
-    void QuaternionToEuler(
-        float q0, float q1, float q2, float q3, 
-        float& pitch, float& roll, float& yaw);
+private:
+    float sampleFreq;
+    float samplePeriod;
+    float minDt;                                    // shorter steps are timestamp glitches
+    float twoKp;                                    // 2 * proportional gain (Kp)
+    float twoKi;                                    // 2 * integral gain (Ki)
+    float integralFBx, integralFBy, integralFBz;    // integral error terms scaled by Ki
 };
 
 } // mahony
@@ -4,32 +4,70 @@
 #include "config/DeviceConfig.h"
 #include "config/ConfigManager.h"
 #include "config/WiFiProvisionerManager.h"
+#include "config/GestureStore.h"
+#include "config/MappingStore.h"
 #include "OscSenderManager.h"
+#include "OscReceiverManager.h"
+#include "MidiMapper.h"
 #include <button.hpp>
-#include "yin/yin_fixed.h"
 #include "imu/ImuReader.h" //content from https://github.com/naninunenoy/AxisOrange/blob/master/src/main.cpp
-#include "imu/AverageCalc.h"
+#include "imu/SampleTimer.h"
+#include "imu/TraceRecorder.h"
+#include "sensors/SensorScheduler.h"
+#include "audio/MicCapture.h"
+#include "audio/OnsetDetector.h"
+#include "audio/PitchTracker.h"
+#include "util/SpscQueue.h"
+#ifdef AHRS_BENCHMARK
+#include "imu/AhrsBenchmark.h"
+#endif
 
 //IMU settings
 #define MAIN_THREAD_SLEEP_IMU 20 // = 50[Hz]
-#define TASK_SLEEP_IMU 5 // = 1000[ms] / 200[Hz]
-#define MUTEX_DEFAULT_WAIT 500UL
+#define IMU_USE_FIFO 1 // burst read the IMU's on-chip FIFO instead of polling single samples
+#define IMU_SAMPLE_RATE_HZ 200 // 200, 400 or 1000
+#define IMU_FIFO_DRAIN_RATE_HZ 200 // with the FIFO the task only needs to wake up to drain it
+#define IMU_AHRS imu::AHRS_MAHONY // AHRS_MAHONY, AHRS_MADGWICK or AHRS_COMPLEMENTARY, can be changed over OSC
+#define TEMPO_CLOCK_CONFIDENCE 0.5f // MIDI clock only runs while the movement's tempo is this sure
 imu::ImuReader* imuReader;
-imu::ImuData imuData;
-imu::AverageCalcXYZ gyroAve;
-bool gyroOffsetInstalled = false;
-static SemaphoreHandle_t imuDataMutex = NULL;
-int imuSampleCounter = 0;
-uint32_t imuSampleCounterTime = 0;
+imu::ImuData imuData; // main loop's copy of the latest IMU frame
+uint32_t imuDataVersion = 0;
+imu::SampleTimer imuSampleTimer;
+imu::TraceRecorder imuTrace; // raw samples over serial for bench/imu_replay, started with /trace/record 1
+imu::SampleTimer::Stats imuTimingStats; // task wake up timing of the last second
+uint32_t imuTimingStatsTime = 0;
 bool buttonAPressed = false;
+bool tempoClock = false; // MIDI clock from the movement's tempo, switched with /tempo/clock
+int64_t lastClockTick = 0;
+
+//add-on sensors, compiled in with their build flags (see platformio.ini)
+sensors::SensorScheduler sensorScheduler;
+sensors::SensorFrame sensorFrame = { }; // main loop's copy of the latest outputs
+uint32_t sensorFrameVersion = 0;
+SemaphoreHandle_t groveBusMutex = NULL;
+
+//audio settings
+// build with -D AUDIO_PITCH_TO_MIDI for the built-in microphone's onset notes, note on and pitch bend
+#define AUDIO_SAMPLE_RATE_HZ 16000 // hops of 128 samples (yin/yin_stream.h), 8 ms: one DMA buffer and one pitch estimate
+audio::MicCapture micCapture;
+audio::OnsetDetector onsetDetector;
+audio::PitchTracker pitchTracker;
+SpscQueue<audio::OnsetEvent, 16> onsetEvents; // from the audio task to the main loop
+SpscQueue<audio::PitchEvent, 32> pitchEvents; // from the audio task to the main loop
+uint8_t pitchNoteChannel = 0; // of the sung note, its note off goes there too
+uint32_t audioEventsDropped = 0; // onsets and pitch events the main loop was too late for
 
 
 //device & wifi config
 DeviceConfig deviceConfig;
 OscSenderManager oscSenderManager;
+OscReceiverManager oscReceiverManager(oscSenderManager.getUdp());
 bool startProvisioning = false;
 WiFiProvisionerManager wifiProvisioner;
 ConfigManager config;
+GestureStore gestureStore; // recorded gestures and what they play, recorded with /gesture/record
+imu::GestureTemplate gestureTemplates[imu::GestureRecognizer::MaxTemplates] = { }; // main loop's copies, as stored
+MappingStore mappingStore; // source to MIDI mappings, set with /map/set
 TaskHandle_t dnsTaskHandle = NULL; // Add task handle for DNS discovery
 
 //appmode
@@ -37,7 +75,6 @@ enum ApplicationMode {
   APP_MODE_WIFI_PROVISIONING,
   APP_MODE_CONNECTING,
   APP_MODE_CONNECTION_FAILED,
-  APP_MODE_CALIBRATING, //on boot
   APP_MODE_SET_ZERO, //on boot
   APP_MODE_TAP_AND_IMU
 };
@@ -45,33 +82,15 @@ ApplicationMode appMode = APP_MODE_CONNECTING;
 
 
 
-//appmode
-enum StreamOptions {
-  STREAM_PITCH_JAW_ROLL_TAP,
-  STREAM_PITCH,
-  STREAM_JAW,
-  STREAM_ROLL,
-  STREAM_TAP,
-  STEAM_OFF,
-  COUNT //helper to track size
-};
-
 StreamOptions streamMode = STREAM_PITCH_JAW_ROLL_TAP;
-StreamOptions nextStreamMode(StreamOptions c) {
-    return static_cast<StreamOptions>((static_cast<int>(c) + 1) % static_cast<int>(StreamOptions::COUNT));
-}
 
 
 void enableCalibration();
 
 //TODO 1 2 3 4 + thread priority + setzero gui
 
-//midi config
-uint8_t midi_channel  = 0; // MIDI channel for messages
-uint8_t midi_tap_note_velocity  = 100;
-uint8_t midi_tap_note_number  = 60;
-static unsigned long noteOnTime = 0;
-static bool noteIsOn = false;
+//midi config: channel 1, tap plays middle C, pitch jaw roll on CC 80 81 82 unless other mappings are stored
+MidiMapper midiMapper;
 
 //button config
 #define BUTTON_A_PIN 37
@@ -92,7 +111,7 @@ String guiProvisionIp = "noconfig";
 
 
 void setupSerial(){
-  Serial.begin(115200);
+  Serial.begin(921600); // fast enough for IMU traces
   while (!Serial); // Wait for serial port to connect. Needed for native USB
 }
 
@@ -178,9 +197,9 @@ bool setupWifi(const DeviceConfig &deviceConfig) {
 
   if (WiFi.status() == WL_CONNECTED) {
     
-    //connected, go in calib mode
-    appMode = APP_MODE_CALIBRATING;
+    //connected, the gyro offset is found while running
     enableCalibration();
+    appMode = APP_MODE_TAP_AND_IMU;
 
     Serial.println("\nWiFi connected successfully");
     Serial.println("IP Address: " + WiFi.localIP().toString());
@@ -223,68 +242,192 @@ void dnsDiscoveryTask(void *parameter) {
   }
 }
 
+// No blocking calibration: the gyro offset is estimated in the IMU task
+// whenever the device lies still, on boot and during the whole show
 void enableCalibration() {
-    appMode = APP_MODE_CALIBRATING;
-    gyroOffsetInstalled = false;
+    M5.Imu.setCalibration(0, 0, 0);
+    M5.Imu.clearOffsetData(); // polled samples raw as well, the tracker corrects both
     imuReader->writeGyroOffset(0.f, 0.f, 0.f);
-    gyroAve.reset();                     
-    M5.Imu.clearOffsetData(); //fixes bug when moing on boot
-    M5.Imu.setCalibration(255, 255, 255);
+    imuReader->enableGyroBiasTracking(true);
 }
 
 /* Main thread pulling imu data, calibration &  calculating AHRS*/
 void ImuLoop(void* arg) {
+  // paced by a hardware timer, not by vTaskDelay with its 1 ms ticks
+  uint32_t rate = IMU_SAMPLE_RATE_HZ;
+  if (imuReader->isFifoEnabled() && rate > IMU_FIFO_DRAIN_RATE_HZ) rate = IMU_FIFO_DRAIN_RATE_HZ;
+  imuSampleTimer.begin(xTaskGetCurrentTaskHandle(), rate);
+  imu::ImuData taskImuData;
+  uint32_t taskImuVersion = 0;
+
   while (1) {
-    int32_t entryTime = millis();
-
-
-    if (appMode == APP_MODE_CALIBRATING || appMode == APP_MODE_SET_ZERO || appMode == APP_MODE_TAP_AND_IMU ) {
-
-        if (xSemaphoreTake(imuDataMutex, MUTEX_DEFAULT_WAIT) == pdTRUE) {
-          imuReader->update();
-          imuReader->read(imuData);
-
-          if (!gyroOffsetInstalled) {
-            
-            if (!gyroAve.push(imuData.gyro[0], imuData.gyro[1], imuData.gyro[2])) {
-              //this runs when the ave list is full (ca 5s)
-              float x = gyroAve.averageX();
-              float y = gyroAve.averageY();
-              float z = gyroAve.averageZ();
-
-              if (abs(x) > 0.02 || abs(y) > 0.02 || abs(z) > 0.02) {
-                Serial.printf("AHRS calibration Failed. \t\t  Offset: %.5f, %.5f, %.5f\tRedoing...\n", x, y, z);
-                gyroAve.reset();
-                M5.Imu.clearOffsetData();
-              } else {
-                M5.Imu.setCalibration(0,0,0);
-
-                //succesfull calib
-                //imuReader->writeGyroOffset(x, y, z);
-                float offset[] = {x, y, z};
-                Serial.printf("AHRS calibration done.  Offset: %.5f, %.5f, %.5f\n", x, y, z);
-                gyroOffsetInstalled = true;
-                appMode = APP_MODE_TAP_AND_IMU;
-              }
-            }
-          }
-          
-          imuSampleCounter++;
-          if (entryTime - imuSampleCounterTime  > 1000) {
-            imuSampleCounterTime = entryTime;
-           Serial.printf("AHRS: Pitch=%.1f° Jaw=%.1f° Roll=%.1f° SR: %i | \n", imuData.orientation[0], imuData.orientation[1], imuData.orientation[2], imuSampleCounter);
-
-            imuSampleCounter = 0;
-          }
-        
+    imuSampleTimer.wait();
+    uint32_t entryTime = millis();
+
+
+    if (appMode == APP_MODE_SET_ZERO || appMode == APP_MODE_TAP_AND_IMU ) {
+
+        // the IMU task never waits for the readers of the published frames
+        imuReader->update();
+        imuReader->read(taskImuData, taskImuVersion);
+
+        if (entryTime - imuTimingStatsTime > 1000) {
+          imuTimingStatsTime = entryTime;
+          imuTimingStats = imuSampleTimer.getStats();
+          imuSampleTimer.resetStats();
+          imu::Ahrs& ahrs = imuReader->getAhrs();
+          imu::Ahrs::CycleStats ahrsCycles = ahrs.getCycleStats();
+          ahrs.resetCycleStats();
+          const imu::GyroBiasTracker& bias = imuReader->getGyroBiasTracker();
+          Serial.printf("AHRS: Pitch=%.1f° Jaw=%.1f° Roll=%.1f° | gyro bias %.3f %.3f %.3f ±%.3f (%lu) | rate %lu Hz, interval %.1f us, jitter %.1f us, max dev %ld us, missed %lu | %s %lu cycles/update, max %lu\n",
+            taskImuData.orientation[0], taskImuData.orientation[1], taskImuData.orientation[2],
+            bias.getBias()[0], bias.getBias()[1], bias.getBias()[2], bias.getUncertainty(), (unsigned long) bias.getUpdateCount(),
+            (unsigned long) imuSampleTimer.getRate(), imuTimingStats.meanInterval, imuTimingStats.jitter,
+            (long) imuTimingStats.maxDeviation, (unsigned long) imuTimingStats.missed,
+            ahrs.name(), (unsigned long) ahrsCycles.mean, (unsigned long) ahrsCycles.max);
         }
-        xSemaphoreGive(imuDataMutex);
+      
+    }
+  }
+}
+
+// polls the add-on sensors on the scheduler's fixed tick, below the IMU task
+void SensorLoop(void* arg) {
+  TickType_t wakeTime = xTaskGetTickCount();
+  while (1) {
+    sensorScheduler.tick(esp_timer_get_time());
+    vTaskDelayUntil(&wakeTime, pdMS_TO_TICKS(sensors::SensorScheduler::TickPeriod / 1000));
+  }
+}
+
+// the Grove I2C bus is held once per scheduler tick for all its due sensors
+void accessSensorBus(sensors::SensorBus bus, bool acquire) {
+  if (bus != sensors::BUS_GROVE_I2C) return;
+  if (acquire) {
+    xSemaphoreTake(groveBusMutex, portMAX_DELAY);
+  } else {
+    xSemaphoreGive(groveBusMutex);
+  }
+}
+
+//creates the sensor thread when sensors are compiled in
+void setupSensors() {
+  if (sensors::SensorRegistry::count() == 0) return;
+  groveBusMutex = xSemaphoreCreateMutex();
+  for (int i = 0; i < sensors::SensorRegistry::count(); i++) {
+    // the Grove pins are either I2C or analog
+    if (sensors::SensorRegistry::get(i)->getBus() == sensors::BUS_GROVE_I2C) {
+      M5.Ex_I2C.begin();
+      break;
+    }
+  }
+  sensorScheduler.setBusAccess(accessSensorBus);
+  int running = sensorScheduler.begin();
+  for (int i = 0; i < sensors::SensorRegistry::count(); i++) {
+    sensors::Sensor* sensor = sensors::SensorRegistry::get(i);
+    Serial.printf("Sensor %s: outputs from source %d, every %lu us\n", sensor->name(),
+      SOURCE_EXT_0 + sensors::SensorRegistry::getOutputBase(i), (unsigned long) sensor->getPeriod());
+  }
+  if (running > 0) {
+    xTaskCreatePinnedToCore(SensorLoop, "SensorTask", 4096UL, NULL, 10, NULL, 0);
+  }
+}
+
+/* Audio thread: one hop from the microphone's DMA, its onset, pitch and notes */
+void AudioLoop(void* arg) {
+  static int16_t hop[audio::PitchTracker::HopSize];
+  audio::PitchEvent events[audio::PitchTracker::MaxEvents];
+  uint32_t statsTime = 0;
+  uint32_t analysisSum = 0;
+  uint32_t analysisMax = 0;
+  uint32_t hops = 0;
+
+  while (1) {
+    int64_t timestamp;
+    if (!micCapture.read(hop, timestamp)) {
+      vTaskDelay(1);
+      continue;
+    }
+    // the analysis has to finish within a hop or the DMA overruns
+    int64_t start = esp_timer_get_time();
+    audio::OnsetEvent onset;
+    bool hasOnset = onsetDetector.process(hop, audio::PitchTracker::HopSize, timestamp, onset);
+    int count = pitchTracker.process(hop, timestamp, hasOnset ? &onset : nullptr, events);
+    uint32_t analysis = (uint32_t) (esp_timer_get_time() - start);
+    if (hasOnset && !onsetEvents.push(onset)) audioEventsDropped++;
+    for (int i = 0; i < count; i++) {
+      if (!pitchEvents.push(events[i])) audioEventsDropped++;
     }
+    analysisSum += analysis;
+    if (analysis > analysisMax) analysisMax = analysis;
+    hops++;
+
+    uint32_t now = millis();
+    if (now - statsTime > 1000) {
+      statsTime = now;
+      Serial.printf("Audio: %.1f Hz, probability %.2f, level %.3f, note %d | analysis %lu us per hop, max %lu | lost hops %lu, dropped events %lu\n",
+        pitchTracker.getPitch(), pitchTracker.getProbability(), pitchTracker.getLevel(), pitchTracker.getNote(),
+        (unsigned long) (analysisSum / hops), (unsigned long) analysisMax,
+        (unsigned long) micCapture.getOverrunCount(), (unsigned long) audioEventsDropped);
+      analysisSum = 0;
+      analysisMax = 0;
+      hops = 0;
+    }
+  }
+}
 
+//creates the audio thread on core 1, above the main loop: the IMU and WiFi share core 0
+void setupAudio() {
+#ifdef AUDIO_PITCH_TO_MIDI
+  onsetDetector.begin(AUDIO_SAMPLE_RATE_HZ);
+  pitchTracker.begin(AUDIO_SAMPLE_RATE_HZ);
+  if (!micCapture.begin(AUDIO_SAMPLE_RATE_HZ, audio::PitchTracker::HopSize)) {
+    Serial.println("Microphone setup failed, no pitch to MIDI");
+    return;
+  }
+  xTaskCreatePinnedToCore(AudioLoop, "AudioTask", 4096UL, NULL, 15, NULL, 1);
+#endif
+}
+
+#ifdef AHRS_BENCHMARK
+/* Cycle cost of the AHRS backends, build with -D AHRS_BENCHMARK */
+void runAhrsBenchmark() {
+  imu::AhrsBenchmark* benchmark = new imu::AhrsBenchmark();
+  imu::mahony::MahonyAHRS mahony;
+  imu::madgwick::MadgwickAHRS madgwick;
+  imu::complementary::ComplementaryFilter complementary;
+  imu::Ahrs* backends[] = { &mahony, &madgwick, &complementary };
+  uint32_t mhz = getCpuFrequencyMhz();
+  for (imu::Ahrs* ahrs : backends) {
+    imu::AhrsBenchmark::Result result = benchmark->run(*ahrs);
+    Serial.printf("AHRS benchmark %-13s %7.1f cycles %6.2f us per update, max %lu cycles, q %.4f %.4f %.4f %.4f\n",
+      result.name, result.meanCycles, result.meanCycles / mhz, (unsigned long) result.maxCycles,
+      result.quat[0], result.quat[1], result.quat[2], result.quat[3]);
+  }
+  delete benchmark;
+}
+#endif
+
+// templates go into the recognizer before the IMU task runs
+void loadGestures() {
+  gestureStore.begin();
+  for (int slot = 0; slot < imu::GestureRecognizer::MaxTemplates; slot++) {
+    imu::GestureTemplate gesture;
+    GestureMidi midi;
+    if (gestureStore.load(slot, gesture, midi)) {
+      imuReader->loadGesture(slot, gesture);
+      gestureTemplates[slot] = gesture;
+      midiMapper.setGestureMidi(slot, midi);
+      Serial.printf("Gesture %d loaded: %d frames, threshold %d\n", slot, gesture.length, gesture.threshold);
+    }
+  }
+}
 
-    // idle
-    int32_t sleep = TASK_SLEEP_IMU - (millis() - entryTime);
-    vTaskDelay((sleep > 0) ? sleep : 0);
+// stores the main loop's copy of the slot's template with its MIDI message
+void saveGesture(int slot) {
+  const imu::GestureTemplate& gesture = gestureTemplates[slot];
+  if (gesture.length > 0) {
+    gestureStore.save(slot, gesture, midiMapper.getGestureMidi(slot));
   }
 }
 
@@ -292,20 +435,185 @@ void ImuLoop(void* arg) {
 void setupIMU() {
   imuReader = new imu::ImuReader(M5.Imu);
   imuReader->initialize(); 
-  imuDataMutex = xSemaphoreCreateMutex();
+  imuReader->setSampleRate(IMU_SAMPLE_RATE_HZ);
+  imuReader->setAhrs(IMU_AHRS);
+  imuReader->setTraceRecorder(&imuTrace);
+  loadGestures();
+#if IMU_USE_FIFO
+  if (!imuReader->enableFifo(IMU_SAMPLE_RATE_HZ)) {
+    Serial.println("IMU FIFO setup failed, polling instead");
+  }
+#endif
   xTaskCreatePinnedToCore(ImuLoop, "IMUtask", 8192UL, NULL, /* 1 low - 24 high, was 2 */ 20, NULL, 0);
 }
 
+/* Settings sent back by a receiver or a computer on the sender's OSC socket */
+void onOscCommand(MicroOscMessage& message) {
+  if (message.checkOscAddressAndTypeTags("/ahrs/gains", "ff")) {
+    float kp = message.nextAsFloat();
+    float ki = message.nextAsFloat();
+    if (kp >= 0 && ki >= 0) {
+      imuReader->setAhrsGains(kp, ki);
+      Serial.printf("AHRS gains set: Kp %.3f Ki %.3f\n", kp, ki);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/tap/threshold", "f")) {
+    float threshold = message.nextAsFloat();
+    if (threshold > 0) {
+      imuReader->setTapThreshold(threshold);
+      Serial.printf("Tap threshold set: %.2f g\n", threshold);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/tempo/clock", "i")) {
+    tempoClock = message.nextAsInt() != 0;
+    Serial.printf("Tempo clock %s\n", tempoClock ? "on" : "off");
+  } else if (message.checkOscAddressAndTypeTags("/tempo/min", "f")) {
+    float bpm = message.nextAsFloat();
+    if (bpm >= 30 && bpm <= 150) {
+      imuReader->setMinTempo(bpm);
+      Serial.printf("Tempo range set: %.0f - %.0f BPM\n", bpm, 2 * bpm);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/features/rate", "f")) {
+    float rate = message.nextAsFloat();
+    if (rate >= 1 && rate <= 50) {
+      imuReader->setMotionFeatureRate(rate);
+      Serial.printf("Motion descriptors: %.0f per second\n", rate);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/onset/threshold", "f")) {
+    float threshold = message.nextAsFloat();
+    if (threshold > 0) {
+      onsetDetector.setThreshold(threshold);
+      Serial.printf("Onset threshold set: %.1f dB\n", threshold);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/onset/note", "i")) {
+    int32_t note = message.nextAsInt();
+    if (note >= 0) {
+      midiMapper.setOnsetNote(note > 127 ? 128 : note);
+      Serial.printf("Onset note set: %d\n", note > 127 ? -1 : note);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/gesture/record", "i")) {
+    int32_t slot = message.nextAsInt();
+    if (imuReader->recordGesture(slot)) {
+      Serial.printf("Gesture %d: recording, move now\n", slot);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/gesture/clear", "i")) {
+    int32_t slot = message.nextAsInt();
+    if (imuReader->clearGesture(slot)) {
+      gestureTemplates[slot].length = 0;
+      gestureStore.remove(slot);
+      Serial.printf("Gesture %d cleared\n", slot);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/gesture/threshold", "ii")) {
+    int32_t slot = message.nextAsInt();
+    int32_t threshold = message.nextAsInt();
+    if (threshold > 0 && threshold < 65536 && imuReader->setGestureThreshold(slot, threshold)) {
+      // the IMU task applies it on its next sample, the stored copy is updated here
+      gestureTemplates[slot].threshold = threshold;
+      saveGesture(slot);
+      Serial.printf("Gesture %d threshold set: %d\n", slot, threshold);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/gesture/note", "ii") ||
+             message.checkOscAddressAndTypeTags("/gesture/program", "ii")) {
+    bool note = message.checkOscAddressAndTypeTags("/gesture/note", "ii");
+    int32_t slot = message.nextAsInt();
+    int32_t number = message.nextAsInt();
+    if (slot >= 0 && slot < imu::GestureRecognizer::MaxTemplates && number >= 0 && number < 128) {
+      GestureMidi midi = { (uint8_t) (note ? 0x90 : 0xC0), (uint8_t) number };
+      midiMapper.setGestureMidi(slot, midi);
+      saveGesture(slot);
+      Serial.printf("Gesture %d plays %s %d\n", slot, note ? "note" : "program", number);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/map/set", "iiffiiiiii")) {
+    // slot, source, min, max, curve, invert, target, channel, number, span
+    int32_t slot = message.nextAsInt();
+    int32_t source = message.nextAsInt();
+    float minValue = message.nextAsFloat();
+    float maxValue = message.nextAsFloat();
+    int32_t curve = message.nextAsInt();
+    int32_t invert = message.nextAsInt();
+    int32_t target = message.nextAsInt();
+    int32_t channel = message.nextAsInt();
+    int32_t number = message.nextAsInt();
+    int32_t span = message.nextAsInt();
+    // checked before they are narrowed to the mapping's bytes
+    bool inRange = source >= 0 && source < SOURCE_COUNT && curve >= 0 && curve < CURVE_COUNT
+        && target >= 0 && target < TARGET_COUNT && channel >= 0 && channel <= 15
+        && number >= 0 && number <= 127 && span >= 0 && span <= 127;
+    Mapping mapping = { };
+    mapping.source = source;
+    mapping.min = minValue;
+    mapping.max = maxValue;
+    mapping.curve = curve;
+    mapping.invert = invert ? 1 : 0;
+    mapping.target = target;
+    mapping.channel = channel;
+    mapping.number = number;
+    mapping.span = span;
+    if (inRange && midiMapper.setMapping(slot, mapping)) {
+      mappingStore.save(midiMapper);
+      Serial.printf("Mapping %d set: source %d to target %d\n", slot, mapping.source, mapping.target);
+    } else {
+      Serial.printf("Mapping %d rejected\n", slot);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/map/smooth", "iff")) {
+    // slot, One Euro min cutoff (Hz, 0 off), beta
+    int32_t slot = message.nextAsInt();
+    float minCutoff = message.nextAsFloat();
+    float beta = message.nextAsFloat();
+    if (slot >= 0 && slot < MidiMapper::MaxMappings && minCutoff >= 0 && beta >= 0) {
+      Mapping mapping = midiMapper.getMapping(slot);
+      mapping.minCutoff = minCutoff;
+      mapping.beta = beta;
+      if (midiMapper.setMapping(slot, mapping)) {
+        mappingStore.save(midiMapper);
+        Serial.printf("Mapping %d smoothing: min cutoff %.2f Hz, beta %.3f\n", slot, minCutoff, beta);
+      }
+    }
+  } else if (message.checkOscAddressAndTypeTags("/map/clear", "i")) {
+    int32_t slot = message.nextAsInt();
+    if (slot >= 0 && slot < MidiMapper::MaxMappings) {
+      midiMapper.clearMapping(slot);
+      mappingStore.save(midiMapper);
+      Serial.printf("Mapping %d cleared\n", slot);
+    }
+  } else if (message.checkOscAddressAndTypeTags("/map/reset", "")) {
+    midiMapper.resetMappings();
+    mappingStore.clear();
+    Serial.println("Mappings reset to CC 80 81 82");
+  } else if (message.checkOscAddressAndTypeTags("/trace/record", "i")) {
+    if (message.nextAsInt()) {
+      imuTrace.start();
+    } else {
+      imuTrace.stop();
+    }
+    Serial.printf("# trace %s\n", imuTrace.isRecording() ? "started" : "stopped");
+  } else if (message.checkOscAddressAndTypeTags("/ahrs/engine", "i")) {
+    int32_t type = message.nextAsInt();
+    if (type >= 0 && type < imu::AHRS_TYPE_COUNT && imuReader->setAhrs((imu::AhrsType) type)) {
+      Serial.printf("AHRS engine set: %s\n", imuReader->getAhrs().name());
+    }
+  } else {
+    Serial.println("Received OSC message with unhandled address");
+  }
+}
+
 
 void setup() {
   setupSerial();
+#ifdef AHRS_BENCHMARK
+  runAhrsBenchmark();
+#endif
   setupDevice();
   setupDisplay();
   setupButtons();
   setupIMU();
+  setupSensors();
+  setupAudio();
 
  
   config.begin();
+  mappingStore.begin();
+  if (mappingStore.load(midiMapper)) {
+    Serial.println("Mappings loaded");
+  }
 
   if (config.hasValidConfig()){
     deviceConfig = config.getConfig();    
@@ -317,6 +625,7 @@ void setup() {
 
 
   oscSenderManager.begin();
+  oscReceiverManager.setMessageHandler(onOscCommand);
 
   // Create DNS discovery task on core 0 (background)
   xTaskCreatePinnedToCore(
@@ -339,9 +648,11 @@ void handleButtons() {
 }
 
 
+// MIDI messages are collected in a bundle stamped with the IMU sample time,
+// the receiver uses the time tag to play them out with constant latency
 void sendMidiMessage(uint8_t midi_channel, uint8_t midi_command, uint8_t data1, uint8_t data2) {
   int midiMessage[3] = {midi_command + midi_channel, data1, data2};
-  oscSenderManager.sendIntArrayToAll("/midi", midiMessage, 3);
+  oscSenderManager.addIntArrayToBundle("/midi", midiMessage, 3);
 }
 
 void sendCCValue(uint8_t midi_channel, uint8_t midi_cc_number, uint8_t midi_cc_value) {
@@ -357,43 +668,156 @@ void sendNoteOff(uint8_t midi_channel, uint8_t note, uint8_t velocity) {
 }
 
 
+void sendMidiOut(uint8_t status, uint8_t data1, uint8_t data2) {
+  sendMidiMessage(status & 0x0F, status & 0xF0, data1, data2);
+}
+
 void sendMidiImuData(){
 
-    if (streamMode == STREAM_TAP || streamMode == STREAM_PITCH_JAW_ROLL_TAP) {
-      float accel_magnitude = sqrt(imuData.acc[0] * imuData.acc[0] + imuData.acc[1]*imuData.acc[1] + imuData.acc[2] * imuData.acc[2]);
-      if (accel_magnitude > 3.0 && !noteIsOn) {
-        Serial.println("Accel magnitude: " + String(accel_magnitude));
-        // Send note on
-        sendNoteOn(midi_channel, midi_tap_note_number, midi_tap_note_velocity); // Note On, Middle C, velocity 100
-        noteOnTime = millis();
-        noteIsOn = true;
-      }
-      if (noteIsOn && (millis() - noteOnTime >= 100)) {
-        // Send note off after 500ms
-        sendNoteOff(midi_channel, midi_tap_note_number, 0);
-        // Todo changing the channel whilst in note on status could result in hanging note
-        noteIsOn = false;
-      }  
+    // IMU axes and add-on sensor outputs go through the same mappings
+    float sources[SOURCE_COUNT] = { };
+    readImuSources(imuData, sources);
+    sensorScheduler.read(sensorFrame, sensorFrameVersion);
+    for (int i = 0; i < sensorFrame.count; i++) {
+      sources[SOURCE_EXT_0 + i] = sensorFrame.values[i];
     }
 
-    
-    if (streamMode == STREAM_PITCH || streamMode == STREAM_PITCH_JAW_ROLL_TAP) { 
-      //send midi pitch bend message and map theta to pitch bend range
-      int theta = map(imuData.orientation[0], -90, 90, 0, 127);
-      theta = constrain(theta, 0, 127);
-      sendCCValue(midi_channel, 80, theta); // CC 80 is a custom CC for pitch bend in this case
-    }
-    if (streamMode == STREAM_JAW || streamMode == STREAM_PITCH_JAW_ROLL_TAP) {
-      int phi = map(imuData.orientation[1], -90, 90, 0, 126);
-      phi = constrain(phi, 0, 127);
-      sendCCValue(midi_channel, 81, phi); // CC 81 is a custom CC for jaw movement in this case
+    oscSenderManager.beginBundle(imuData.timestamp);
+    midiMapper.process(sources, imuData.timestamp, streamMode, sendMidiOut);
+    oscSenderManager.sendBundleToAll();
+}
+
+// Taps go out as soon as the IMU task found them, each in its own bundle
+// stamped with the time of the hit
+void sendTapEvents() {
+  imu::TapEvent tap;
+  while (imuReader->popTapEvent(tap)) {
+    if (appMode != APP_MODE_TAP_AND_IMU) continue;
+    oscSenderManager.beginBundle(tap.timestamp);
+    midiMapper.processTap(tap, streamMode, sendMidiOut);
+    oscSenderManager.sendBundleToAll();
+  }
+}
+
+// Gestures are sent like taps, stamped with the end of the movement.
+// A freshly recorded template is stored in NVS, from the copy the IMU task
+// handed over.
+void sendGestureEvents() {
+  imu::RecordedGesture recorded;
+  while (imuReader->popRecordedGesture(recorded)) {
+    gestureTemplates[recorded.slot] = recorded.gesture;
+    saveGesture(recorded.slot);
+    Serial.printf("Gesture %d recorded: %d frames, threshold %d\n", recorded.slot, recorded.gesture.length, recorded.gesture.threshold);
+  }
+  imu::GestureEvent gesture;
+  while (imuReader->popGestureEvent(gesture)) {
+    if (gesture.recorded) continue;
+    if (appMode != APP_MODE_TAP_AND_IMU) continue;
+    oscSenderManager.beginBundle(gesture.timestamp);
+    midiMapper.processGesture(gesture, streamMode, sendMidiOut);
+    oscSenderManager.sendBundleToAll();
+  }
+}
+
+// Onsets from the microphone are sent like taps, stamped with the start of
+// the sound
+void sendOnsetEvents() {
+  audio::OnsetEvent onset;
+  while (onsetEvents.pop(onset)) {
+    if (appMode != APP_MODE_TAP_AND_IMU) continue;
+    oscSenderManager.beginBundle(onset.timestamp);
+    midiMapper.processOnset(onset, streamMode, sendMidiOut);
+    oscSenderManager.sendBundleToAll();
+  }
+}
+
+// Notes and pitch bend from the microphone, stamped with the capture time of
+// their audio. Messages of the same hop share a bundle, so the bend before
+// a note on arrives with it. Note offs are always sent so that no note hangs
+// when the stream is switched off.
+void sendPitchEvents() {
+  audio::PitchEvent event;
+  bool bundleOpen = false;
+  int64_t bundleTime = 0;
+  while (pitchEvents.pop(event)) {
+    // the note off of a sounding note always goes out, on the note's channel
+    bool noteOff = event.status == 0x80;
+    if (!noteOff && (appMode != APP_MODE_TAP_AND_IMU || streamMode == STEAM_OFF)) continue;
+    if (bundleOpen && event.timestamp != bundleTime) {
+      oscSenderManager.sendBundleToAll();
+      bundleOpen = false;
     }
-    if (streamMode == STREAM_ROLL || streamMode == STREAM_PITCH_JAW_ROLL_TAP) {     
-      int psi = map(imuData.orientation[2], -90, 90, 0, 127);
-      psi = constrain(psi, 0, 127);
-      sendCCValue(midi_channel, 82, psi); // CC 82 is a custom CC for roll movement in this case
+    if (!bundleOpen) {
+      oscSenderManager.beginBundle(event.timestamp);
+      bundleTime = event.timestamp;
+      bundleOpen = true;
     }
+    if (event.status == 0x90) pitchNoteChannel = midiMapper.getChannel();
+    uint8_t channel = noteOff ? pitchNoteChannel : midiMapper.getChannel();
+    sendMidiOut(event.status | channel, event.data1, event.data2);
+  }
+  if (bundleOpen) {
+    oscSenderManager.sendBundleToAll();
+  }
+}
 
+// MIDI clock from the movement's tempo: 24 ticks per beat on the tempo
+// tracker's beat grid, each in its own bundle stamped with its time. The
+// clock pauses while the tempo is unsure; start and stop are left to the DAW.
+void sendMidiClock() {
+  if (!tempoClock || appMode != APP_MODE_TAP_AND_IMU || streamMode == STEAM_OFF) return;
+  if (imuData.tempo <= 0.0f || imuData.tempoConfidence < TEMPO_CLOCK_CONFIDENCE) return;
+  // differences of the us timestamps are taken in int64 before they are
+  // scaled, a float timestamp loses whole ticks after a few hours
+  double beat = 60e6 / imuData.tempo;
+  double tick = beat / 24;
+  int64_t beatStart = imuData.timestamp - (int64_t) (imuData.tempoPhase * beat);
+  int64_t now = esp_timer_get_time();
+  if (now - lastClockTick > (int64_t) beat) {
+    // (re)starting: the first tick is the next one on the grid
+    lastClockTick = now - (int64_t) tick;
+  }
+  // the grid's first tick after the last one sent, which may have been a
+  // little off the grid when the tempo changed
+  int64_t since = lastClockTick - beatStart;
+  int64_t index = (int64_t) ceil((since + tick / 2) / tick);
+  int64_t next = beatStart + (int64_t) (index * tick);
+  while (next <= now) {
+    oscSenderManager.beginBundle(next);
+    sendMidiOut(0xF8, 0, 0);
+    oscSenderManager.sendBundleToAll();
+    lastClockTick = next;
+    index++;
+    next = beatStart + (int64_t) (index * tick);
+  }
+}
+
+// note offs for the tap, gesture and onset notes, stamped with their end
+void releaseMidiNote() {
+  int64_t releaseTime;
+  while ((releaseTime = midiMapper.getNoteReleaseTime()) != 0 && esp_timer_get_time() >= releaseTime) {
+    oscSenderManager.beginBundle(releaseTime);
+    midiMapper.releaseNote(sendMidiOut);
+    oscSenderManager.sendBundleToAll();
+  }
+}
+
+// note name with 60 as C3
+String noteName(uint8_t note) {
+  static const char* names[12] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+  return String(names[note % 12]) + String(note / 12 - 2);
+}
+
+// what the first mapping of an orientation axis sends, e.g. "CC80 pitch"
+String mappingLabel(uint8_t source, const char* name) {
+  for (int i = 0; i < MidiMapper::MaxMappings; i++) {
+    const Mapping& mapping = midiMapper.getMapping(i);
+    if (mapping.source != source) continue;
+    if (mapping.target == TARGET_CC) return "CC" + String(mapping.number) + " " + name;
+    if (mapping.target == TARGET_NOTE) return noteName(mapping.number) + "+ " + name;
+    if (mapping.target == TARGET_PITCH_BEND) return String("Bend ") + name;
+  }
+  return String("- ") + name;
 }
 
 uint32_t guiUpdated = 0;
@@ -418,17 +842,6 @@ void updateGui(bool force) {
         canvas.drawCenterString(guiConnecedId, M5.Display.width() / 2, 75);
         canvas.setTextSize(2);
     }
-    else if (appMode == APP_MODE_CALIBRATING) {
-        canvas.drawCenterString("Paired to", M5.Display.width() / 2, 10);    
-        //receiver ID based on SSID
-        canvas.drawCenterString("Rec " + guiConnecedId, M5.Display.width() / 2, 30);
-        canvas.drawLine(0,50,M5.Display.width(), 50);
-        canvas.setTextSize(2);
-        canvas.drawCenterString("CALIBRATING", M5.Display.width() / 2, 80);   
-        canvas.setTextSize(3);
-        canvas.drawCenterString("LAY", M5.Display.width() / 2, 130);   
-        canvas.drawCenterString("FLAT", M5.Display.width() / 2, 160);      
-    }
     else if (appMode == APP_MODE_CONNECTION_FAILED) {
        canvas.drawCenterString("Connection", M5.Display.width() / 2, 10);    
 
@@ -447,7 +860,9 @@ void updateGui(bool force) {
     else if (appMode == APP_MODE_TAP_AND_IMU) {
       canvas.drawCenterString("Paired to", M5.Display.width() / 2, 10);    
       canvas.drawCenterString("Rec " + guiConnecedId, M5.Display.width() / 2, 30);
-      canvas.drawCenterString("Midi Ch 1", M5.Display.width() / 2, 50);
+      // until the device has been still once the gyro offset is unknown
+      if (imuReader->getGyroBiasTracker().hasEstimate()) canvas.drawCenterString("Midi Ch " + String(midiMapper.getChannel() + 1), M5.Display.width() / 2, 50);
+      else canvas.drawCenterString("Hold still", M5.Display.width() / 2, 50);
       canvas.drawLine(0,75,M5.Display.width(), 75);
 
       
@@ -462,10 +877,10 @@ void updateGui(bool force) {
     } else {
       //default gui
       if (streamMode == STEAM_OFF) canvas.drawString("Off", 7, 90);
-      if (streamMode == STREAM_PITCH || streamMode == STREAM_PITCH_JAW_ROLL_TAP)  canvas.drawString("CC80 pitch", 7, 90);
-      if (streamMode == STREAM_JAW || streamMode == STREAM_PITCH_JAW_ROLL_TAP) canvas.drawString("CC81 jaw", 7, 110);
-      if (streamMode == STREAM_ROLL || streamMode == STREAM_PITCH_JAW_ROLL_TAP) canvas.drawString("CC82 roll", 7, 130);
-      if (streamMode == STREAM_TAP || streamMode == STREAM_PITCH_JAW_ROLL_TAP) canvas.drawString("C3 = tap", 7, 150);
+      if (streamMode == STREAM_PITCH || streamMode == STREAM_PITCH_JAW_ROLL_TAP)  canvas.drawString(mappingLabel(SOURCE_PITCH, "pitch"), 7, 90);
+      if (streamMode == STREAM_JAW || streamMode == STREAM_PITCH_JAW_ROLL_TAP) canvas.drawString(mappingLabel(SOURCE_JAW, "jaw"), 7, 110);
+      if (streamMode == STREAM_ROLL || streamMode == STREAM_PITCH_JAW_ROLL_TAP) canvas.drawString(mappingLabel(SOURCE_ROLL, "roll"), 7, 130);
+      if (streamMode == STREAM_TAP || streamMode == STREAM_PITCH_JAW_ROLL_TAP) canvas.drawString(noteName(midiMapper.getTapNote()) + " " + noteName(midiMapper.getDoubleTapNote()) + " tap", 7, 150);
       canvas.drawLine(0,175,M5.Display.width(), 175);
 
 
@@ -499,9 +914,21 @@ void updateGui() {
 }
 
 
+// write recorded IMU samples without blocking on the serial port
+void writeTrace() {
+  char line[128];
+  while (Serial.availableForWrite() >= (int) sizeof(line)) {
+    int length = imuTrace.nextLine(line, sizeof(line));
+    if (length <= 0) break;
+    Serial.write((const uint8_t*) line, length);
+  }
+}
+
+
 void loop(){  
   
   int32_t entryTime = millis();
+  imuReader->read(imuData, imuDataVersion);
   updateGui();
   
   //this also checks if provisioning is started from the button
@@ -520,11 +947,19 @@ void loop(){
 
   handleButtons();
 
-  
-
-  
-  int32_t sleep = MAIN_THREAD_SLEEP_IMU - (millis() - entryTime);
-    delay((sleep > 0) ? sleep : 0);  //50 hz
+  // idle, but keep answering receiver clock sync requests quickly:
+  // time spent waiting in the socket counts as network delay
+  do {
+    oscReceiverManager.update();
+    sendTapEvents();
+    sendGestureEvents();
+    sendOnsetEvents();
+    sendPitchEvents();
+    sendMidiClock();
+    releaseMidiNote();
+    writeTrace();
+    delay(1);
+  } while (millis() - entryTime < MAIN_THREAD_SLEEP_IMU); //50 hz
 
 }
 
@@ -0,0 +1,29 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "GroveAnalogSensor.h"
+#include "SensorRegistry.h"
+
+namespace sensors {
+
+    bool GroveAnalogSensor::begin() {
+        analogReadResolution(12);
+        analogSetPinAttenuation(Pin, ADC_11db);   // full 0 - 3.3 V range
+        return true;
+    }
+
+    bool GroveAnalogSensor::poll(float* outputs) {
+        // a few conversions against the ADC's noise, about 10 us each
+        uint32_t sum = 0;
+        for (int i = 0; i < Oversampling; i++) {
+            sum += analogRead(Pin);
+        }
+        outputs[0] = sum / (Oversampling * 4095.0f);
+        return true;
+    }
+
+#ifdef SENSOR_GROVE_ANALOG
+    REGISTER_SENSOR(GroveAnalogSensor);
+#endif
+
+} // sensors
+#endif // ARDUINO
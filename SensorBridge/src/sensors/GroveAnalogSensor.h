@@ -0,0 +1,28 @@
+#ifndef __SENSORS_GROVE_ANALOG_SENSOR_H__
+#define __SENSORS_GROVE_ANALOG_SENSOR_H__
+
+#include "Sensor.h"
+
+namespace sensors {
+
+// Analog sensor on the Grove port (flex, pressure, potentiometer, ...),
+// read from G33 at 100 Hz. One output, 0 - 1 over the ADC range.
+// Compiled in with -D SENSOR_GROVE_ANALOG.
+class GroveAnalogSensor : public Sensor {
+public:
+    static const int Pin = 33;
+
+    const char* name() const override { return "grove analog"; }
+    uint32_t getPeriod() const override { return 10000; }
+    int getOutputCount() const override { return 1; }
+
+    bool begin() override;
+    bool poll(float* outputs) override;
+
+private:
+    static const int Oversampling = 4;
+};
+
+} // sensors
+
+#endif // __SENSORS_GROVE_ANALOG_SENSOR_H__
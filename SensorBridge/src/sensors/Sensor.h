@@ -0,0 +1,38 @@
+#ifndef __SENSORS_SENSOR_H__
+#define __SENSORS_SENSOR_H__
+
+#include <stdint.h>
+
+namespace sensors {
+
+// Buses shared by several sensors. The scheduler polls the due sensors of
+// one bus back to back, inside one acquisition of the bus.
+enum SensorBus {
+    BUS_NONE,       // ADC, GPIO, ... nothing to share
+    BUS_GROVE_I2C,  // Grove port A, SDA G32 / SCL G33 on the M5StickC Plus2
+    BUS_COUNT
+};
+
+// An add-on sensor polled by the SensorScheduler. Its outputs become the
+// mapping sources SOURCE_EXT_0 ... in registration order (see
+// SensorRegistry.h), so they can be mapped to MIDI like the IMU axes.
+class Sensor {
+public:
+    virtual ~Sensor() { }
+
+    virtual const char* name() const = 0;
+    // time between polls in us, rounded to the scheduler's tick
+    virtual uint32_t getPeriod() const = 0;
+    virtual SensorBus getBus() const { return BUS_NONE; }
+    virtual int getOutputCount() const = 0;
+
+    // Called once before polling starts, false leaves the sensor out
+    virtual bool begin() = 0;
+    // Reads the sensor into outputs[getOutputCount()], false when there
+    // is no new reading
+    virtual bool poll(float* outputs) = 0;
+};
+
+} // sensors
+
+#endif // __SENSORS_SENSOR_H__
@@ -0,0 +1,23 @@
+#include "SensorRegistry.h"
+
+namespace sensors {
+
+    SensorRegistry::Entries& SensorRegistry::entries() {
+        static Entries registered = { };
+        return registered;
+    }
+
+    bool SensorRegistry::add(Sensor* sensor) {
+        Entries& e = entries();
+        int outputs = sensor->getOutputCount();
+        if (e.count >= MaxSensors || e.outputCount + outputs > MaxOutputs) {
+            return false;
+        }
+        e.sensors[e.count] = sensor;
+        e.outputBase[e.count] = e.outputCount;
+        e.count++;
+        e.outputCount += outputs;
+        return true;
+    }
+
+} // sensors
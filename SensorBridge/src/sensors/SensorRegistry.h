@@ -0,0 +1,49 @@
+#ifndef __SENSORS_SENSOR_REGISTRY_H__
+#define __SENSORS_SENSOR_REGISTRY_H__
+
+#include "Sensor.h"
+
+namespace sensors {
+
+// Sensors compiled into the firmware. A sensor registers itself from its
+// own .cpp with REGISTER_SENSOR, usually behind a build flag, so adding
+// one does not touch main.cpp. Registration happens during static
+// initialization, before setup().
+class SensorRegistry {
+public:
+    static const int MaxSensors = 8;
+    static const int MaxOutputs = 8;    // SOURCE_EXT_0 - SOURCE_EXT_7
+
+    // false when the registry or the outputs are full
+    static bool add(Sensor* sensor);
+    static int count() { return entries().count; }
+    static Sensor* get(int index) { return entries().sensors[index]; }
+    // first output of the sensor in the combined outputs
+    static int getOutputBase(int index) { return entries().outputBase[index]; }
+    static int getOutputCount() { return entries().outputCount; }
+
+private:
+    struct Entries {
+        Sensor* sensors[MaxSensors];
+        int outputBase[MaxSensors];
+        int count;
+        int outputCount;
+    };
+    // constructed on first use, whatever the order of static initialization
+    static Entries& entries();
+};
+
+// static instance of a sensor that adds itself to the registry
+template <typename T>
+class SensorRegistration {
+public:
+    SensorRegistration() { SensorRegistry::add(&sensor); }
+private:
+    T sensor;
+};
+
+#define REGISTER_SENSOR(Type) static sensors::SensorRegistration<Type> Type##Registration
+
+} // sensors
+
+#endif // __SENSORS_SENSOR_REGISTRY_H__
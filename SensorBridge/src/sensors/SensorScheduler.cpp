@@ -0,0 +1,72 @@
+#include <string.h>
+#include "SensorScheduler.h"
+
+namespace sensors {
+
+    SensorScheduler::SensorScheduler() : slotCount(0), ticks(0), busAccess(nullptr) {
+        memset(&frame, 0, sizeof(frame));
+    }
+
+    int SensorScheduler::begin() {
+        slotCount = 0;
+        ticks = 0;
+        frame.count = (uint8_t) SensorRegistry::getOutputCount();
+        for (int i = 0; i < SensorRegistry::count(); i++) {
+            Sensor* sensor = SensorRegistry::get(i);
+            if (!sensor->begin()) continue;
+            Slot& slot = slots[slotCount++];
+            slot.sensor = sensor;
+            slot.outputBase = SensorRegistry::getOutputBase(i);
+            slot.divider = (sensor->getPeriod() + TickPeriod / 2) / TickPeriod;
+            if (slot.divider == 0) slot.divider = 1;
+        }
+        // sensors of one bus next to each other, in registration order
+        for (int i = 1; i < slotCount; i++) {
+            Slot slot = slots[i];
+            int j = i;
+            for (; j > 0 && slots[j - 1].sensor->getBus() > slot.sensor->getBus(); j--) {
+                slots[j] = slots[j - 1];
+            }
+            slots[j] = slot;
+        }
+        return slotCount;
+    }
+
+    bool SensorScheduler::tick(int64_t now) {
+        bool updated = false;
+        SensorBus bus = BUS_NONE;
+        for (int i = 0; i < slotCount; i++) {
+            Slot& slot = slots[i];
+            if (ticks % slot.divider != 0) continue;
+
+            SensorBus next = slot.sensor->getBus();
+            if (next != bus && busAccess != nullptr) {
+                if (bus != BUS_NONE) busAccess(bus, false);
+                if (next != BUS_NONE) busAccess(next, true);
+            }
+            bus = next;
+            if (slot.sensor->poll(&frame.values[slot.outputBase])) {
+                updated = true;
+            }
+        }
+        if (bus != BUS_NONE && busAccess != nullptr) {
+            busAccess(bus, false);
+        }
+        ticks++;
+
+        if (updated) {
+            frame.timestamp = now;
+            published.write(frame);
+        }
+        return updated;
+    }
+
+    bool SensorScheduler::read(SensorFrame& outFrame, uint32_t& version) const {
+        if (published.version() == version) {
+            return false; // not updated
+        }
+        version = published.read(outFrame);
+        return true;
+    }
+
+} // sensors
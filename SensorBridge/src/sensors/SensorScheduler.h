@@ -0,0 +1,62 @@
+#ifndef __SENSORS_SENSOR_SCHEDULER_H__
+#define __SENSORS_SENSOR_SCHEDULER_H__
+
+#include <stdint.h>
+#include "Sensor.h"
+#include "SensorRegistry.h"
+#include "../util/SeqLock.h"
+
+namespace sensors {
+
+// latest outputs of all registered sensors
+struct SensorFrame {
+    int64_t timestamp;  // time of the latest poll that changed a value, us
+    uint8_t count;      // outputs in use
+    float values[SensorRegistry::MaxOutputs];
+};
+
+// Polls the registered sensors on one fixed tick: every sensor runs on the
+// multiple of the tick closest to its period, so the schedule repeats
+// exactly. Sensors due in the same tick are polled grouped by bus, each bus
+// is acquired once per tick. Runs in its own task; the outputs are
+// published through a seqlock for the main loop.
+class SensorScheduler {
+public:
+    static const uint32_t TickPeriod = 5000;   // us, 200 Hz
+
+    // acquire (true) or release (false) a shared bus
+    typedef void (*BusAccess)(SensorBus bus, bool acquire);
+
+    SensorScheduler();
+
+    void setBusAccess(BusAccess access) { busAccess = access; }
+    // Begins the registered sensors and builds the schedule. Returns the
+    // number of sensors that will be polled.
+    int begin();
+
+    // Polls the sensors due in this tick, now in us. Returns true when a
+    // new frame was published.
+    bool tick(int64_t now);
+
+    // Consistent copy of the latest frame, false when nothing was
+    // published since version
+    bool read(SensorFrame& outFrame, uint32_t& version) const;
+
+private:
+    struct Slot {
+        Sensor* sensor;
+        int outputBase;
+        uint32_t divider;   // ticks between polls
+    };
+
+    Slot slots[SensorRegistry::MaxSensors];
+    int slotCount;
+    uint32_t ticks;
+    BusAccess busAccess;
+    SensorFrame frame;
+    SeqLock<SensorFrame> published;
+};
+
+} // sensors
+
+#endif // __SENSORS_SENSOR_SCHEDULER_H__
@@ -0,0 +1,78 @@
+#ifndef ONEEUROFILTER_H
+#define ONEEUROFILTER_H
+
+#include <math.h>
+
+/*
+ * One Euro filter (Casiez, Roussel, Vogel 2012): a low-pass whose cutoff
+ * rises with the speed of the signal. At rest the cutoff is minCutoff and
+ * noise is smoothed away, fast moves raise it by beta per unit/s and pass
+ * with little lag. A handful of flops and no table per sample.
+ *
+ * For angles set a wrap period (360): differences are taken the short way
+ * round and the output stays in the input's range.
+ */
+class OneEuroFilter {
+public:
+  OneEuroFilter() : minCutoff(1.0f), beta(0.0f), derivativeCutoff(1.0f), period(0.0f) {
+    reset();
+  }
+
+  // Hz, unit/s of the signal per Hz, Hz
+  void setParameters(float minCutoff, float beta, float derivativeCutoff = 1.0f) {
+    this->minCutoff = minCutoff;
+    this->beta = beta;
+    this->derivativeCutoff = derivativeCutoff;
+  }
+
+  void setWrap(float period) { this->period = period; }
+
+  void reset() {
+    initialized = false;
+    value = 0.0f;
+    speed = 0.0f;
+  }
+
+  // dt in seconds since the previous value; no time passed (the same
+  // sample again) leaves the output as it was
+  float filter(float x, float dt) {
+    if (!initialized) {
+      initialized = true;
+      value = x;
+      speed = 0.0f;
+      return value;
+    }
+    if (!(dt > 0.0f)) return value;
+    float delta = wrap(x - value);
+    speed += alpha(derivativeCutoff, dt) * (delta / dt - speed);
+    float cutoff = minCutoff + beta * fabsf(speed);
+    value = wrap(value + alpha(cutoff, dt) * delta);
+    return value;
+  }
+
+private:
+  // smoothing factor of a first order low-pass at cutoff Hz
+  static float alpha(float cutoff, float dt) {
+    float tau = 1.0f / (2.0f * (float) M_PI * cutoff);
+    return dt / (dt + tau);
+  }
+
+  // into -period/2 - period/2
+  float wrap(float x) const {
+    if (period <= 0.0f) return x;
+    float half = 0.5f * period;
+    if (x > half) x -= period;
+    else if (x < -half) x += period;
+    return x;
+  }
+
+  float minCutoff;
+  float beta;
+  float derivativeCutoff;
+  float period;
+  bool initialized;
+  float value;
+  float speed;
+};
+
+#endif // ONEEUROFILTER_H
@@ -0,0 +1,55 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Single writer publication of a plain struct (a sequence lock).
+ * The writer never waits: it makes the sequence odd, copies the value in and
+ * makes it even again. Readers copy the value out and retry when the sequence
+ * was odd or changed meanwhile, so they only ever see complete values.
+ *
+ * Readers may run on either core, but must not preempt the writer on its own
+ * core for long, they would spin until the writer gets to finish.
+ * T has to be trivially copyable.
+ */
+template <typename T>
+class SeqLock {
+public:
+  SeqLock() : sequence(0) { }
+
+  // Publish a new value, only ever called from one task
+  void write(const T& value) {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&data, &value, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_release);
+    sequence.store(seq + 2, std::memory_order_relaxed);
+  }
+
+  // Copy the latest value, returns its version (number of writes so far)
+  uint32_t read(T& out) const {
+    uint32_t before, after;
+    do {
+      before = sequence.load(std::memory_order_acquire);
+      memcpy(&out, &data, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return before >> 1;
+  }
+
+  // Version of the latest value, without copying it
+  uint32_t version() const {
+    return sequence.load(std::memory_order_acquire) >> 1;
+  }
+
+private:
+  std::atomic<uint32_t> sequence;
+  T data;
+};
+
+#endif // SEQLOCK_H
@@ -0,0 +1,54 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Lock free queue between exactly one producer task and one consumer task.
+ * Neither side ever blocks: push() fails when the queue is full and pop()
+ * when it is empty. N has to be a power of two.
+ */
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+  SpscQueue() : head(0), tail(0) { }
+
+  // producer side
+  bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= N) {
+      return false;
+    }
+    items[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side
+  bool pop(T& item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = items[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+
+private:
+  T items[N];
+  std::atomic<uint32_t> head; // next slot to write, only changed by the producer
+  std::atomic<uint32_t> tail; // next slot to read, only changed by the consumer
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,177 @@
+/**
+ * @file fft.c
+ * @brief Radix-2 complex FFT, esp-dsp on the ESP32 and portable C elsewhere.
+ **/
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "fft.h"
+
+#if defined(ESP_PLATFORM)
+#include "esp_dsp.h"
+#endif
+
+struct Fft {
+
+	size_t size;
+
+	// cos and -sin of 2 pi k / size for k < size / 2, portable version only
+	float * twiddles;
+
+	// cos and -sin of pi k / size for k <= size / 2, to split a real transform
+	float * real_twiddles;
+};
+
+static int is_power_of_two(size_t n) {
+	return n >= 2 && (n & (n - 1)) == 0;
+}
+
+Fft * fft_new(size_t size) {
+	if (!is_power_of_two(size)) {
+		return NULL;
+	}
+	Fft * fft = (Fft *) malloc(sizeof(Fft));
+	if (fft == NULL) {
+		return NULL;
+	}
+	fft->size = size;
+	fft->twiddles = NULL;
+	fft->real_twiddles = (float *) malloc(sizeof(float) * (size + 2));
+	if (fft->real_twiddles == NULL) {
+		free(fft);
+		return NULL;
+	}
+	for (size_t k = 0; k <= size / 2; k++) {
+		double angle = M_PI * (double) k / (double) size;
+		fft->real_twiddles[2 * k] = (float) cos(angle);
+		fft->real_twiddles[2 * k + 1] = (float) -sin(angle);
+	}
+#if defined(ESP_PLATFORM)
+	// esp-dsp keeps one table for all sizes up to CONFIG_DSP_MAX_FFT_SIZE
+	esp_err_t err = dsps_fft2r_init_fc32(NULL, CONFIG_DSP_MAX_FFT_SIZE);
+	if ((err != ESP_OK && err != ESP_ERR_DSP_REINITIALIZED) || size > CONFIG_DSP_MAX_FFT_SIZE) {
+		free(fft->real_twiddles);
+		free(fft);
+		return NULL;
+	}
+#else
+	fft->twiddles = (float *) malloc(sizeof(float) * size);
+	if (fft->twiddles == NULL) {
+		free(fft->real_twiddles);
+		free(fft);
+		return NULL;
+	}
+	for (size_t k = 0; k < size / 2; k++) {
+		double angle = 2.0 * M_PI * (double) k / (double) size;
+		fft->twiddles[2 * k] = (float) cos(angle);
+		fft->twiddles[2 * k + 1] = (float) -sin(angle);
+	}
+#endif
+	return fft;
+}
+
+size_t fft_size(Fft * fft) {
+	return fft->size;
+}
+
+#if !defined(ESP_PLATFORM)
+static void fft_bit_reverse(float * data, size_t n) {
+	size_t j = 0;
+	for (size_t i = 1; i < n; i++) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) {
+			float re = data[2 * i];
+			float im = data[2 * i + 1];
+			data[2 * i] = data[2 * j];
+			data[2 * i + 1] = data[2 * j + 1];
+			data[2 * j] = re;
+			data[2 * j + 1] = im;
+		}
+	}
+}
+#endif
+
+void fft_forward(Fft * fft, float * data) {
+	size_t n = fft->size;
+#if defined(ESP_PLATFORM)
+	dsps_fft2r_fc32(data, n);
+	dsps_bit_rev_fc32(data, n);
+#else
+	fft_bit_reverse(data, n);
+	// butterflies, the twiddle stride halves with every stage
+	for (size_t length = 2; length <= n; length <<= 1) {
+		size_t half = length >> 1;
+		size_t stride = n / length;
+		for (size_t start = 0; start < n; start += length) {
+			for (size_t k = 0; k < half; k++) {
+				float wr = fft->twiddles[2 * k * stride];
+				float wi = fft->twiddles[2 * k * stride + 1];
+				float * a = data + 2 * (start + k);
+				float * b = data + 2 * (start + k + half);
+				float tr = b[0] * wr - b[1] * wi;
+				float ti = b[0] * wi + b[1] * wr;
+				b[0] = a[0] - tr;
+				b[1] = a[1] - ti;
+				a[0] += tr;
+				a[1] += ti;
+			}
+		}
+	}
+#endif
+}
+
+void fft_inverse(Fft * fft, float * data) {
+	size_t n = fft->size;
+	// conj(FFT(conj(x))) / n
+	for (size_t i = 0; i < n; i++) {
+		data[2 * i + 1] = -data[2 * i + 1];
+	}
+	fft_forward(fft, data);
+	float scale = 1.0f / (float) n;
+	for (size_t i = 0; i < n; i++) {
+		data[2 * i] *= scale;
+		data[2 * i + 1] *= -scale;
+	}
+}
+
+void fft_forward_real(Fft * fft, float * data) {
+	size_t n = fft->size;
+	// even samples as the real parts, odd ones as the imaginary parts
+	fft_forward(fft, data);
+
+	float z0r = data[0];
+	float z0i = data[1];
+	data[0] = z0r + z0i;
+	data[1] = z0r - z0i;
+	// bins k and n - k from Z[k] and Z[n - k]:
+	// E = (Z[k] + conj(Z[n - k])) / 2 is the transform of the even samples,
+	// O = (Z[k] - conj(Z[n - k])) / 2i the one of the odd samples,
+	// X[k] = E + W^k O and X[n - k] = conj(E - W^k O) with W = e^(-i pi / n)
+	for (size_t k = 1; k <= n / 2; k++) {
+		float * a = data + 2 * k;
+		float * b = data + 2 * (n - k);
+		float even_re = 0.5f * (a[0] + b[0]);
+		float even_im = 0.5f * (a[1] - b[1]);
+		float odd_re = 0.5f * (a[1] + b[1]);
+		float odd_im = 0.5f * (b[0] - a[0]);
+		float wr = fft->real_twiddles[2 * k];
+		float wi = fft->real_twiddles[2 * k + 1];
+		float tr = wr * odd_re - wi * odd_im;
+		float ti = wr * odd_im + wi * odd_re;
+		a[0] = even_re + tr;
+		a[1] = even_im + ti;
+		b[0] = even_re - tr;
+		b[1] = ti - even_im;
+	}
+}
+
+void fft_destroy(Fft * fft) {
+	free(fft->real_twiddles);
+	free(fft->twiddles);
+	free(fft);
+}
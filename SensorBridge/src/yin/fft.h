@@ -0,0 +1,50 @@
+#include <stddef.h>
+
+#ifndef FFT_H
+#define FFT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @struct Fft
+	 *
+	 * @brief In place complex FFT of a power of two size.
+	 *
+	 * Data is interleaved: real and imaginary part of each value. On the
+	 * ESP32 the FFT is esp-dsp's optimized radix-2 FFT, elsewhere a portable
+	 * radix-2 implementation with the same layout and results.
+	 */
+	typedef struct Fft Fft;
+
+	/**
+	 * Initialize a new @ref Fft for the given number of complex values.
+	 * @return An initialized @ref Fft struct, or NULL when size is not a power of two or memory could not be allocated.
+	 */
+	Fft * fft_new(size_t size);
+
+	size_t fft_size(Fft * fft);
+
+	void fft_forward(Fft * fft, float * data);
+
+	/**
+	 * Inverse transform, scaled by 1 / size so that it undoes @ref fft_forward.
+	 */
+	void fft_inverse(Fft * fft, float * data);
+
+	/**
+	 * Forward transform of 2 * size real values through the complex one of
+	 * size. On return data holds bins 0 to size: data[0] is bin 0 and
+	 * data[1] bin size, both real, followed by the real and imaginary parts
+	 * of bins 1 to size - 1.
+	 */
+	void fft_forward_real(Fft * fft, float * data);
+
+	void fft_destroy(Fft * fft);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FFT_H
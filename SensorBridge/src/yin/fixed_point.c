@@ -76,7 +76,7 @@ void test_fixed_point_div(void) {
         float diff = fabs(float_result - float_expected_result);
 
 
-        float allowed_dif = float_expected_result * 0.1f > 0.1f ? float_expected_result * 0.1f : 0.2f;
+        float allowed_dif = fabs(float_expected_result) * 0.1f > 0.1f ? fabs(float_expected_result) * 0.1f : 0.2f;
 
         //fprintf(stderr, "float_a: %f, float_b: %f, float_result: %f, float_expected_result: %f, diff: %f, allowed diff %f\n", float_a, float_b, float_result, float_expected_result, diff,allowed_dif);
 
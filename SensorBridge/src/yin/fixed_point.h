@@ -4,6 +4,10 @@
 #ifndef FIXED_POINT_H
 #define FIXED_POINT_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef int32_t fixed_point;
 
 fixed_point fixed_point_mul(fixed_point a, fixed_point b);
@@ -16,4 +20,8 @@ float fixed_point_to_f(fixed_point value);
 
 fixed_point fixed_point_from_f(float value);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // FIXED_POINT_H
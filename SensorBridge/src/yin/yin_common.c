@@ -0,0 +1,105 @@
+/**
+ * @file yin_common.c
+ * @brief Parts of the YIN pitch estimation shared by the estimators.
+ * 
+ **/
+
+#include "yin_common.h"
+#include "fixed_point.h"
+
+// the firmware is built for size, this loop is worth unrolling and vectorizing
+__attribute__((optimize("O3")))
+int32_t yin_difference_block(const int16_t * x, size_t count, size_t tau){
+	const int16_t * lagged = x - tau;
+	int32_t sum = 0;
+	for (size_t j = 0; j < count; j++) {
+		// (a >> 1) - (b >> 1) fits 16 bits, its square 31
+		int16_t delta = (int16_t) ((x[j] >> 1) - (lagged[j] >> 1));
+		sum += ((int32_t) delta * delta) >> 13;
+	}
+	return sum;
+}
+
+// normalized(tau) = d(tau) * tau / (d(1) + ... + d(tau)), running_sum is
+// the sum up to tau - 1 and gets d(tau) added
+static float yin_normalize(int32_t difference, size_t tau, float * running_sum){
+	float value = fixed_point_to_f(difference);
+	*running_sum += value;
+	return *running_sum > 0 ? value * tau / *running_sum : 1;
+}
+
+int yin_absolute_threshold(const int32_t * difference, size_t size, float threshold, float * probability){
+	float running_sum = 0;
+	// normalized(0) is always 1 and normalized(1) too close to it,
+	// so start at the third (index 2)
+	for (size_t tau = 1; tau < size; tau++) {
+		float normalized = yin_normalize(difference[tau], tau, &running_sum);
+		if (tau < 2 || normalized >= threshold) {
+			continue;
+		}
+		while (tau + 1 < size) {
+			float next = yin_normalize(difference[tau + 1], tau + 1, &running_sum);
+			if (next >= normalized) {
+				break;
+			}
+			normalized = next;
+			tau++;
+		}
+		// found tau, exit loop and return
+		// store the probability
+		// From the YIN paper: The threshold determines the list of
+		// candidates admitted to the set, and can be interpreted as the
+		// proportion of aperiodic power tolerated
+		// within a ëëperiodicíí signal.
+		//
+		// Since we want the periodicity and and not aperiodicity:
+		// periodicity = 1 - aperiodicity
+		*probability = 1 - normalized;
+		return tau;
+	}
+	// no pitch found
+	*probability = 0;
+	return -1;
+}
+
+float yin_parabolic_interpolation(const int32_t * difference, size_t size, size_t tau_estimate) {
+	float better_tau;
+	size_t x0;
+	size_t x2;
+	
+	if (tau_estimate < 1) {
+		x0 = tau_estimate;
+	} else {
+		x0 = tau_estimate - 1;
+	}
+
+	if (tau_estimate + 1 < size) {
+		x2 = tau_estimate + 1;
+	} else {
+		x2 = tau_estimate;
+	}
+
+	if (x0 == tau_estimate) {
+		if (difference[tau_estimate] <= difference[x2]) {
+			better_tau = tau_estimate;
+		} else {
+			better_tau = x2;
+		}
+	} else if (x2 == tau_estimate) {
+		if (difference[tau_estimate] <= difference[x0]) {
+			better_tau = tau_estimate;
+		} else {
+			better_tau = x0;
+		}
+	} else {
+		float s0, s1, s2;
+		s0 = fixed_point_to_f(difference[x0]);
+		s1 = fixed_point_to_f(difference[tau_estimate]);
+		s2 = fixed_point_to_f(difference[x2]);
+		// fixed AUBIO implementation, thanks to Karl Helgason:
+		// (2.0f * s1 - s2 - s0) was incorrectly multiplied with -1
+		better_tau = tau_estimate + (s2 - s0) / (2 * (2 * s1 - s2 - s0));
+	}
+
+	return better_tau;
+}
@@ -0,0 +1,44 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef YIN_COMMON_H
+#define YIN_COMMON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * Parts of YIN shared by the buffer and the streaming estimator. The
+	 * difference function has the scale of the fixed point sum of
+	 * (delta^2 >> 15).
+	 */
+
+	/**
+	 * Step 2 for one block of samples: the sum over j < count of
+	 * (x[j] - x[j - tau])^2 at the difference function's scale. x[-tau] must
+	 * be valid. Samples lose their lowest bit so that a difference fits 16
+	 * bits, and the loop has no dependency between samples but the sum:
+	 * compilers process several samples per instruction where the CPU has
+	 * SIMD.
+	 */
+	int32_t yin_difference_block(const int16_t * x, size_t count, size_t tau);
+
+	/**
+	 * Steps 3 and 4: the cumulative mean normalized difference, computed
+	 * while looking for the first dip below the threshold, followed to its
+	 * minimum. No buffer is needed for the normalized values.
+	 * @return The lag of the dip, or -1 without one. The probability is 0 then.
+	 */
+	int yin_absolute_threshold(const int32_t * difference, size_t size, float threshold, float * probability);
+
+	/**
+	 * Step 5: the lag refined between its neighbours.
+	 */
+	float yin_parabolic_interpolation(const int32_t * difference, size_t size, size_t tau_estimate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // YIN_COMMON_H
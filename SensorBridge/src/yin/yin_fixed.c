@@ -3,16 +3,19 @@
  * @brief This file contains an implementation of a pitch estimation algorithm YIN.
  * 
  * The implementation uses some fixed point operations to speed up the algorithm.
+ * The difference function is computed through an FFT autocorrelation in
+ * O(N log N) instead of the direct O(N^2) sum.
  * 
  **/
 
 
 
 #include <stdlib.h>
-#include <stdio.h>
 
 #include "yin_fixed.h"
 #include "fixed_point.h"
+#include "yin_common.h"
+#include "fft.h"
 
 //state information
 struct Yin_Fixed {
@@ -25,148 +28,132 @@ struct Yin_Fixed {
 
 	float probability;
 
+	// difference function, normalized on the fly
 	int32_t * yin_buffer_fixed;
 
-	float * yin_buffer_float;
+	// complex FFT work buffer, at least the buffer size
+	Fft * fft;
+
+	float * fft_buffer;
 };
 
+static size_t next_power_of_two(size_t n) {
+	size_t size = 2;
+	while (size < n) {
+		size <<= 1;
+	}
+	return size;
+}
+
 
 Yin_Fixed * yin_fixed_new(float sample_rate, size_t buffer_size) {
 	Yin_Fixed * yin = (Yin_Fixed *) malloc(sizeof(Yin_Fixed));
+	if (yin == NULL) {
+		return NULL;
+	}
 	yin->half_buffer_size = buffer_size / 2;
 	yin->sample_rate = sample_rate;
 	yin->threshold = 0.15f;
 	yin->probability = -1.0;
 	yin->yin_buffer_fixed = (int32_t *) malloc(sizeof(int32_t) * yin->half_buffer_size);
-	yin->yin_buffer_float = (float   *) malloc(sizeof(float)   * yin->half_buffer_size);
-	for (size_t i = 0; i < yin->half_buffer_size; i++) {
-		yin->yin_buffer_fixed[i] = 0;
-		yin->yin_buffer_float[i] = 0;
+	if (yin->yin_buffer_fixed == NULL) {
+		free(yin);
+		return NULL;
+	}
+	// the correlation of the first half with the whole buffer does not wrap
+	// around in an FFT of the buffer's size
+	yin->fft = fft_new(next_power_of_two(buffer_size));
+	if (yin->fft == NULL) {
+		free(yin->yin_buffer_fixed);
+		free(yin);
+		return NULL;
+	}
+	yin->fft_buffer = (float *) malloc(sizeof(float) * 2 * fft_size(yin->fft));
+	if (yin->fft_buffer == NULL) {
+		fft_destroy(yin->fft);
+		free(yin->yin_buffer_fixed);
+		free(yin);
+		return NULL;
 	}
 	return yin;
 }
 
+/**
+ * d(tau) = sum over j < W of (x[j] - x[j + tau])^2, W half the buffer, is
+ * expanded into e(0) + e(tau) - 2 r(tau): e(tau) the energy of the window
+ * starting at tau, r(tau) the correlation of the first half with the buffer.
+ * r comes from one complex FFT holding both real sequences (the first half
+ * as real part, the whole buffer as imaginary part) and one inverse FFT.
+ * The result has the scale of the direct fixed point sum of (delta^2 >> 15).
+ */
 void yin_fixed_difference(Yin_Fixed * yin,int16_t* buffer){
-	size_t index;
-	size_t tau;
-	int32_t delta;
-	for(tau = 0 ; tau < yin->half_buffer_size; tau++){
-		for(index = 0; index < yin->half_buffer_size; index++){
-			delta = fixed_point_sum(buffer[index], -buffer[index + tau]);
-			yin->yin_buffer_fixed[tau] += fixed_point_mul(delta,delta);
+	size_t n = fft_size(yin->fft);
+	size_t w = yin->half_buffer_size;
+	float * z = yin->fft_buffer;
+
+	for (size_t j = 0; j < n; j++) {
+		float x = j < 2 * w ? buffer[j] : 0.0f;
+		z[2 * j] = j < w ? x : 0.0f;
+		z[2 * j + 1] = x;
+	}
+	fft_forward(yin->fft, z);
+
+	// separate the spectra A (first half) and B (buffer), then conj(A) * B,
+	// bins k and n - k together as each needs the other
+	for (size_t k = 0; k <= n / 2; k++) {
+		size_t m = (n - k) & (n - 1);
+		float zr = z[2 * k], zi = z[2 * k + 1];
+		float mr = z[2 * m], mi = z[2 * m + 1];
+		// A[k] = (Z[k] + conj(Z[m])) / 2, B[k] = (Z[k] - conj(Z[m])) / 2i
+		float ar = 0.5f * (zr + mr), ai = 0.5f * (zi - mi);
+		float br = 0.5f * (zi + mi), bi = -0.5f * (zr - mr);
+		z[2 * k] = ar * br + ai * bi;
+		z[2 * k + 1] = ar * bi - ai * br;
+		if (m != k) {
+			// A[m] = conj(A[k]), B[m] = conj(B[k])
+			z[2 * m] = z[2 * k];
+			z[2 * m + 1] = -z[2 * k + 1];
 		}
-		yin->yin_buffer_float[tau]	= fixed_point_to_f(yin->yin_buffer_fixed[tau]);	
 	}
-}
-
-void yin_fixed_cumulative_mean_normalized_difference(Yin_Fixed * yin){
-	size_t tau;
-	yin->yin_buffer_float[0] = 1;
-	float running_sum = 0;
+	fft_inverse(yin->fft, z);
 
-	for (tau = 1; tau < yin->half_buffer_size; tau++) {
-		running_sum += yin->yin_buffer_float[tau];
-		//printf("floating fixed %d %f \n" ,tau, yin->yin_buffer_float[tau]);
-		yin->yin_buffer_float[tau] = yin->yin_buffer_float[tau] * tau / running_sum;
-		//printf("floating fixed %d %f %f\n" ,tau, yin->yin_buffer_float[tau],running_sum);
+	float energy_start = 0.0f;
+	for (size_t j = 0; j < w; j++) {
+		energy_start += (float) buffer[j] * buffer[j];
+	}
+	float energy = energy_start;
+	for (size_t tau = 0; tau < w; tau++) {
+		float difference = energy_start + energy - 2.0f * z[2 * tau];
+		if (difference < 0.0f) {
+			difference = 0.0f; // rounding at a perfect match
+		}
+		yin->yin_buffer_fixed[tau] = (int32_t) (difference * (1.0f / 32768.0f) + 0.5f);
+		energy += (float) buffer[tau + w] * buffer[tau + w] - (float) buffer[tau] * buffer[tau];
 	}
 }
 
 int yin_fixed_absolute_threshold(Yin_Fixed * yin){
-	size_t tau;
-	// first two positions in yin->yin_buffer_fixed are always 1
-	// So start at the third (index 2)
-	for (tau = 2; tau < yin->half_buffer_size ; tau++) {
-		if (yin->yin_buffer_float[tau] < yin->threshold) {
-			while (tau + 1 < yin->half_buffer_size && yin->yin_buffer_float[tau + 1] < yin->yin_buffer_float[tau]) {
-				tau++;
-			}
-			// found tau, exit loop and return
-			// store the probability
-			// From the YIN paper: The threshold determines the list of
-			// candidates admitted to the set, and can be interpreted as the
-			// proportion of aperiodic power tolerated
-			// within a ëëperiodicíí signal.
-			//
-			// Since we want the periodicity and and not aperiodicity:
-			// periodicity = 1 - aperiodicity
-			yin->probability = 1 - yin->yin_buffer_float[tau];
-			break;
-		}
-	}
-	// if no pitch found, tau => -1
-	if (tau == yin->half_buffer_size || yin->yin_buffer_float[tau] >= yin->threshold) {
-		tau = -1;
-		yin->probability = 0;
-	}
-	return tau;
+	return yin_absolute_threshold(yin->yin_buffer_fixed, yin->half_buffer_size, yin->threshold, &yin->probability);
 }
 
 float yin_fixed_parabolic_interpolation(Yin_Fixed * yin,size_t tau_estimate) {
-	float better_tau;
-	size_t x0;
-	size_t x2;
-	
-	if (tau_estimate < 1) {
-		x0 = tau_estimate;
-	} else {
-		x0 = tau_estimate - 1;
-	}
-
-	if (tau_estimate + 1 < yin->half_buffer_size) {
-		x2 = tau_estimate + 1;
-	} else {
-		x2 = tau_estimate;
-	}
-
-	if (x0 == tau_estimate) {
-		if (yin->yin_buffer_fixed[tau_estimate] <= yin->yin_buffer_fixed[x2]) {
-			better_tau = tau_estimate;
-		} else {
-			better_tau = x2;
-		}
-	} else if (x2 == tau_estimate) {
-		if (yin->yin_buffer_fixed[tau_estimate] <= yin->yin_buffer_fixed[x0]) {
-			better_tau = tau_estimate;
-		} else {
-			better_tau = x0;
-		}
-	} else {
-		float s0, s1, s2;
-		s0 = fixed_point_to_f(yin->yin_buffer_fixed[x0]);
-		s1 = fixed_point_to_f(yin->yin_buffer_fixed[tau_estimate]);
-		s2 = fixed_point_to_f(yin->yin_buffer_fixed[x2]);
-		// fixed AUBIO implementation, thanks to Karl Helgason:
-		// (2.0f * s1 - s2 - s0) was incorrectly multiplied with -1
-		better_tau = tau_estimate + (s2 - s0) / (2 * (2 * s1 - s2 - s0));
-	}
-
-	return better_tau;
+	return yin_parabolic_interpolation(yin->yin_buffer_fixed, yin->half_buffer_size, tau_estimate);
 }
 
 
 float yin_fixed_estimate_pitch(Yin_Fixed * yin,int16_t* buffer){
 
-	for (size_t i = 0; i < yin->half_buffer_size; i++) {
-		yin->yin_buffer_fixed[i] = 0;
-		yin->yin_buffer_float[i] = 0;
-	}
-
 	int tauEstimate = -1;
 	float pitchInHertz = -1;
 	
 	//step 2
 	yin_fixed_difference(yin,buffer);
 	
-	// step 3
-	yin_fixed_cumulative_mean_normalized_difference(yin);
-	
-	//step 4
+	// step 3 and 4
 	tauEstimate = yin_fixed_absolute_threshold(yin);
 	
 	//step 5
 	if(tauEstimate != -1){
-		printf("%d \n" , tauEstimate);
 		pitchInHertz = yin->sample_rate / yin_fixed_parabolic_interpolation(yin,tauEstimate);
 	}	
 	return pitchInHertz;
@@ -178,6 +165,7 @@ float yin_fixed_last_pitch_estimate_probability(Yin_Fixed * yin){
 
 void yin_fixed_destroy(Yin_Fixed * yin) {
 	free(yin->yin_buffer_fixed);
-	free(yin->yin_buffer_float);	
+	free(yin->fft_buffer);
+	fft_destroy(yin->fft);
 	free(yin);
 }
@@ -6,6 +6,10 @@
 #ifndef YIN_FIXED_H
 #define YIN_FIXED_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 	/**
 	 * @struct Yin_Fixed
 	 *
@@ -17,7 +21,7 @@
 
 	/**
 	 * Initialize a new @ref Yin_Fixed struct according to the given configuration.
-	 * @return An initialized @ref Yin_Fixed struct or undefined if memory could not be allocated.
+	 * @return An initialized @ref Yin_Fixed struct or NULL if memory could not be allocated.
 	 */
 	Yin_Fixed * yin_fixed_new(float sample_rate,size_t buffer_size);
 
@@ -31,4 +35,8 @@
 	 */ 
 	void yin_fixed_destroy(Yin_Fixed * yin_fixed) ;
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // YIN_FIXED_H
@@ -0,0 +1,59 @@
+/**
+ * @file yin_stream.c
+ * @brief Streaming version of the YIN pitch estimation, see yin_stream.h.
+ * 
+ * With W the window size, d(tau) = sum over the newest W samples x[j] of
+ * (x[j] - x[j - tau])^2. The window is made of W / hop blocks, the sums of
+ * each block are kept for every lag so the oldest block can be taken out
+ * again exactly: integer sums do not drift.
+ * 
+ **/
+
+#include <string.h>
+
+#include "yin_stream.h"
+#include "yin_common.h"
+
+#define W YIN_STREAM_WINDOW_SIZE
+#define H YIN_STREAM_HOP_SIZE
+
+void yin_stream_init(Yin_Stream * yin, float sample_rate) {
+	memset(yin, 0, sizeof(Yin_Stream));
+	yin->sample_rate = sample_rate;
+	yin->threshold = 0.15f;
+	yin->probability = -1.0;
+}
+
+float yin_stream_push_hop(Yin_Stream * yin, const int16_t * hop) {
+	memmove(yin->history, yin->history + H, sizeof(int16_t) * (2 * W - H));
+	memcpy(yin->history + 2 * W - H, hop, sizeof(int16_t) * H);
+	if (yin->received < 2 * W) {
+		yin->received += H;
+	}
+
+	// the new hop replaces the oldest block of the window
+	const int16_t * x = yin->history + 2 * W - H;
+	int32_t * block = yin->block_sums[yin->oldest_block];
+	for (size_t tau = 0; tau < W; tau++) {
+		int32_t sum = yin_difference_block(x, H, tau);
+		yin->difference[tau] += sum - block[tau];
+		block[tau] = sum;
+	}
+	yin->oldest_block = (yin->oldest_block + 1) % YIN_STREAM_BLOCKS;
+
+	// until then, the window or its lags still reach back before the first sample
+	if (yin->received < 2 * W) {
+		yin->probability = 0;
+		return -1;
+	}
+
+	int tau_estimate = yin_absolute_threshold(yin->difference, W, yin->threshold, &yin->probability);
+	if (tau_estimate == -1) {
+		return -1;
+	}
+	return yin->sample_rate / yin_parabolic_interpolation(yin->difference, W, tau_estimate);
+}
+
+float yin_stream_last_pitch_estimate_probability(const Yin_Stream * yin) {
+	return yin->probability;
+}
@@ -0,0 +1,82 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef YIN_STREAM_H
+#define YIN_STREAM_H
+
+/**
+ * Window and hop size, fixed at compile time. The window is the longest
+ * period that can be found (32 ms at 16 kHz) and a multiple of the hop.
+ */
+#ifndef YIN_STREAM_WINDOW_SIZE
+#define YIN_STREAM_WINDOW_SIZE 512
+#endif
+
+#ifndef YIN_STREAM_HOP_SIZE
+#define YIN_STREAM_HOP_SIZE 128
+#endif
+
+#if YIN_STREAM_WINDOW_SIZE % YIN_STREAM_HOP_SIZE != 0
+#error "YIN_STREAM_WINDOW_SIZE must be a multiple of YIN_STREAM_HOP_SIZE"
+#endif
+
+#define YIN_STREAM_BLOCKS (YIN_STREAM_WINDOW_SIZE / YIN_STREAM_HOP_SIZE)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/**
+	 * @struct Yin_Stream
+	 *
+	 * @brief Streaming YIN: one pitch estimate per hop of audio.
+	 * 
+	 * The difference function covers the newest window of samples and is
+	 * updated hop by hop: the sums of the hop that entered the window are
+	 * added, those of the hop that left it subtracted. A hop costs its
+	 * length times the window size, an estimate lags the audio by one hop
+	 * instead of a full buffer.
+	 *
+	 * All state is in the struct, sized at compile time: the caller places
+	 * it (statically, or as a member) and nothing is allocated. The fields
+	 * are private.
+	 */
+	typedef struct Yin_Stream {
+
+		float sample_rate;
+
+		float threshold;
+
+		float probability;
+
+		size_t received;
+
+		size_t oldest_block;
+
+		// the newest 2 * window samples, oldest first
+		int16_t history[2 * YIN_STREAM_WINDOW_SIZE];
+
+		// the sums of each block in the window for every lag, a ring of blocks
+		int32_t block_sums[YIN_STREAM_BLOCKS][YIN_STREAM_WINDOW_SIZE];
+
+		int32_t difference[YIN_STREAM_WINDOW_SIZE];
+	} Yin_Stream;
+
+	/**
+	 * Initialize a @ref Yin_Stream struct, also forgets the audio so far.
+	 */
+	void yin_stream_init(Yin_Stream * yin_stream, float sample_rate);
+
+	/**
+	 * Add the next YIN_STREAM_HOP_SIZE samples.
+	 * @return The pitch in Hz of the newest window, or -1 without one. Until twice the window size was pushed there is none.
+	 */
+	float yin_stream_push_hop(Yin_Stream * yin_stream, const int16_t * hop);
+
+	float yin_stream_last_pitch_estimate_probability(const Yin_Stream * yin_stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // YIN_STREAM_H